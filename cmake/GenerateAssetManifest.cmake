@@ -0,0 +1,114 @@
+# Generates a header which lists every asset file and every named resource inside the json bundles as an AssetID.
+# The game resolves the ids through flat tables of preparsed uris and handles (see src/resource/assets.hpp),
+# referencing an asset which does not exist is therefore a compile error.
+# The assets referenced by the uris of each scene are listed as <scene id>_REFERENCES so that the residency sets of the
+# levels are derived from their scene files.
+
+function(asset_identifier PATH OUT)
+    string(TOUPPER "${PATH}" ID)
+    string(MAKE_C_IDENTIFIER "${ID}" ID)
+    set(${OUT} "ASSET_${ID}" PARENT_SCOPE)
+endfunction()
+
+function(generate_asset_manifest ASSET_DIR OUTPUT)
+    file(GLOB_RECURSE FILES RELATIVE ${ASSET_DIR} ${ASSET_DIR}/*)
+    list(SORT FILES)
+
+    set(PATHS)
+    foreach (FILE ${FILES})
+        list(APPEND PATHS ${FILE})
+        if (FILE MATCHES "\\.json$" AND NOT FILE MATCHES "^scenes/")
+            file(READ ${ASSET_DIR}/${FILE} JSON)
+            string(JSON MEMBERS ERROR_VARIABLE ERR LENGTH "${JSON}")
+            if (ERR)
+                continue()
+            endif ()
+            math(EXPR LAST_MEMBER "${MEMBERS} - 1")
+            foreach (I RANGE ${LAST_MEMBER})
+                string(JSON KEY MEMBER "${JSON}" ${I})
+                string(JSON TYPE TYPE "${JSON}" ${KEY})
+                if (NOT TYPE STREQUAL "ARRAY")
+                    continue()
+                endif ()
+                string(JSON ELEMENTS LENGTH "${JSON}" ${KEY})
+                if (ELEMENTS EQUAL 0)
+                    continue()
+                endif ()
+                math(EXPR LAST_ELEMENT "${ELEMENTS} - 1")
+                foreach (E RANGE ${LAST_ELEMENT})
+                    string(JSON NAME ERROR_VARIABLE ERR GET "${JSON}" ${KEY} ${E} name)
+                    if (NOT ERR AND NOT NAME STREQUAL "")
+                        list(APPEND PATHS "${FILE}/${NAME}")
+                    endif ()
+                endforeach ()
+            endforeach ()
+        endif ()
+    endforeach ()
+
+    set(IDS "")
+    set(STRINGS "")
+    foreach (PATH ${PATHS})
+        asset_identifier(${PATH} ID)
+        string(APPEND IDS "    ${ID},\n")
+        string(APPEND STRINGS "        \"${PATH}\",\n")
+    endforeach ()
+
+    set(REFERENCES "")
+    foreach (FILE ${FILES})
+        if (NOT FILE MATCHES "^scenes/.*\\.json$")
+            continue()
+        endif ()
+        file(READ ${ASSET_DIR}/${FILE} JSON)
+        string(REGEX MATCHALL "\"uri\"[ \t\r\n]*:[ \t\r\n]*\"[^\"]*\"" URIS "${JSON}")
+        set(REFERENCED)
+        foreach (URI ${URIS})
+            string(REGEX REPLACE "^\"uri\"[ \t\r\n]*:[ \t\r\n]*\"([^\"]*)\"$" "\\1" URI "${URI}")
+            if (NOT URI IN_LIST PATHS)
+                message(WARNING "${FILE} references ${URI} which is not an asset")
+                continue()
+            endif ()
+            asset_identifier(${URI} ID)
+            list(APPEND REFERENCED ${ID})
+        endforeach ()
+        list(REMOVE_DUPLICATES REFERENCED)
+        list(LENGTH REFERENCED COUNT)
+        list(JOIN REFERENCED ",\n        " REFERENCED)
+        asset_identifier(${FILE} ID)
+        string(APPEND REFERENCES "
+constexpr std::array<AssetID, ${COUNT}> ${ID}_REFERENCES = {
+        ${REFERENCED}
+};
+")
+    endforeach ()
+
+    set(CONTENT "// Generated by cmake/GenerateAssetManifest.cmake from the asset directory, do not edit.
+
+#ifndef FOXTROT_ASSETMANIFEST_HPP
+#define FOXTROT_ASSETMANIFEST_HPP
+
+#include <array>
+
+enum AssetID : int {
+${IDS}
+    ASSET_COUNT
+};
+
+constexpr const char *ASSET_PATHS[ASSET_COUNT] = {
+${STRINGS}};
+${REFERENCES}
+#endif //FOXTROT_ASSETMANIFEST_HPP
+")
+
+    # Only touch the header if the content has changed to avoid recompiling
+    if (EXISTS ${OUTPUT})
+        file(READ ${OUTPUT} EXISTING)
+    endif ()
+    if (NOT "${EXISTING}" STREQUAL "${CONTENT}")
+        file(WRITE ${OUTPUT} "${CONTENT}")
+    endif ()
+
+    # Reconfigure when assets are added or modified
+    foreach (FILE ${FILES})
+        set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${ASSET_DIR}/${FILE})
+    endforeach ()
+endfunction()
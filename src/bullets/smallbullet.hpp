@@ -24,11 +24,11 @@
 
 #include "components/bulletcomponent.hpp"
 
+#include "resource/assets.hpp"
+
 using namespace xng;
 
 namespace SmallBullet {
-    static const std::string animUri = "animations/bullet_small.json";
-
     static const std::string colPath = "colliders/smallbullet.json";
 
     static bool initialized = false;
@@ -61,14 +61,16 @@ namespace SmallBullet {
                 bytes);
     }
 
-    Entity create(EntityScene &scene,
-                  const Transform &transform,
-                  const Vec3f &velocity,
-                  const std::string &canvas,
-                  float damage = 10) {
+    /**
+     * Create the components of a small bullet on the entity.
+     */
+    void create(Entity &ent,
+                const Transform &transform,
+                const Vec3f &velocity,
+                const std::string &canvas,
+                float damage = 10) {
         init();
 
-        auto ent = scene.createEntity();
         auto t = TransformComponent();
         t.transform = transform;
         ent.createComponent(t);
@@ -87,12 +89,11 @@ namespace SmallBullet {
    //     sprite.layer = 5;
         ent.createComponent(sprite);
         auto anim = SpriteAnimationComponent();
-        anim.animation = ResourceHandle<SpriteAnimation>(Uri(animUri));
+        anim.animation = ResourceHandle<SpriteAnimation>(Assets::uri(ASSET_ANIMATIONS_BULLET_SMALL_JSON));
         ent.createComponent(anim);
         auto bullet = BulletComponent();
         bullet.damage = damage;
         ent.createComponent(bullet);
-        return ent;
     }
 }
 
@@ -32,7 +32,7 @@ struct InputComponent : public Component {
 
     bool aim = false; // If true the user wants to aim to the aimPosition
     Vec2f aimPosition; // The cursor position relative to the screen
-    bool fire = false; // If true the user wants to shoot in this frame
+    bool fire = false; // If true the user wants to shoot, cleared by the simulation step which handles it
     bool fireHold = false; // If true the user wants to shoot in this frame
     bool reload = false; // If true the user wants to reload in this frame
     Vec2f movement = Vec2f(0); // The normalized input movement vector
@@ -0,0 +1,67 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_LEVELCOMPONENTS_HPP
+#define FOXTROT_LEVELCOMPONENTS_HPP
+
+#include <tuple>
+
+#include "xng/xng.hpp"
+
+#include "components/backdropcomponent.hpp"
+#include "components/bulletcomponent.hpp"
+#include "components/charactercontrollercomponent.hpp"
+#include "components/floorcomponent.hpp"
+#include "components/fpscomponent.hpp"
+#include "components/healthcomponent.hpp"
+#include "components/inputcomponent.hpp"
+#include "components/muzzleflashcomponent.hpp"
+#include "components/npccomponent.hpp"
+#include "components/playercomponent.hpp"
+
+using namespace xng;
+
+/**
+ * Every component type which is created in the levels, from the scene files or by the systems.
+ *
+ * Code which has to handle each component type of an entity, such as the chunk streaming, is checked
+ * against this list at compile time. A new component type must be added here.
+ */
+typedef std::tuple<AudioListenerComponent,
+        AudioSourceComponent,
+        BackdropComponent,
+        BulletComponent,
+        ButtonComponent,
+        CanvasComponent,
+        CharacterControllerComponent,
+        FloorComponent,
+        FpsComponent,
+        HealthComponent,
+        InputComponent,
+        MuzzleFlashComponent,
+        NpcComponent,
+        PlayerComponent,
+        RectTransformComponent,
+        RigidBodyComponent,
+        SpriteAnimationComponent,
+        SpriteComponent,
+        TextComponent,
+        TransformComponent> LevelComponents;
+
+#endif //FOXTROT_LEVELCOMPONENTS_HPP
@@ -0,0 +1,262 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_COMMANDREGISTRY_HPP
+#define FOXTROT_COMMANDREGISTRY_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <optional>
+#include <charconv>
+#include <array>
+#include <algorithm>
+
+#include "consolecommand.hpp"
+#include "consoleoutput.hpp"
+
+/**
+ * Converts a command argument to the type requested by the command handler.
+ */
+template<typename T, typename Enable = void>
+struct ArgumentParser;
+
+template<>
+struct ArgumentParser<std::string> {
+    static constexpr const char *TYPE_NAME = "string";
+
+    static bool parse(std::string_view str, std::string &value) {
+        value = str;
+        return true;
+    }
+};
+
+template<>
+struct ArgumentParser<bool> {
+    static constexpr const char *TYPE_NAME = "bool";
+
+    static bool parse(std::string_view str, bool &value) {
+        if (str == "1" || str == "true" || str == "on") {
+            value = true;
+            return true;
+        } else if (str == "0" || str == "false" || str == "off") {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+};
+
+template<typename T>
+struct ArgumentParser<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+    static constexpr const char *TYPE_NAME = std::is_integral_v<T> ? "int" : "float";
+
+    static bool parse(std::string_view str, T &value) {
+        auto end = str.data() + str.size();
+        auto result = std::from_chars(str.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+};
+
+// Enumerations such as LevelID are entered as their numeric value
+template<typename T>
+struct ArgumentParser<T, std::enable_if_t<std::is_enum_v<T>>> {
+    static constexpr const char *TYPE_NAME = "int";
+
+    static bool parse(std::string_view str, T &value) {
+        std::underlying_type_t<T> v;
+        if (!ArgumentParser<std::underlying_type_t<T>>::parse(str, v))
+            return false;
+        value = static_cast<T>(v);
+        return true;
+    }
+};
+
+/**
+ * The commands which can be invoked from the console.
+ *
+ * Commands are looked up by name without allocating, their arguments are parsed according to the
+ * parameter types of the handler before it is invoked.
+ * Trailing std::optional parameters may be omitted by the user.
+ */
+class CommandRegistry {
+public:
+    /**
+     * Returns the possible values of the argument at the given index.
+     */
+    typedef std::function<std::vector<std::string>(size_t argument)> Completer;
+
+    struct Command {
+        std::string name;
+        std::string help;
+        std::string usage;
+        std::function<void(const ConsoleCommand &, ConsoleOutput &)> handler;
+        Completer completer;
+    };
+
+    /**
+     * Register a command, replacing any existing command with the same name.
+     *
+     * @tparam Args The types of the arguments passed to the handler
+     * @param name
+     * @param help A short description of the command displayed by the help command
+     * @param argumentNames The names of the arguments displayed in the usage string
+     * @param handler Invoked with the output and the parsed arguments
+     * @param completer Optional completion of argument values
+     */
+    template<typename... Args, typename F>
+    void add(const std::string &name,
+             const std::string &help,
+             const std::array<const char *, sizeof...(Args)> &argumentNames,
+             F handler,
+             Completer completer = {}) {
+        auto usage = createUsage<Args...>(name, argumentNames, std::index_sequence_for<Args...>());
+        commands[name] = Command{
+                name,
+                help,
+                usage,
+                [handler, usage](const ConsoleCommand &command, ConsoleOutput &output) {
+                    dispatch<Args...>(handler, command, output, usage, std::index_sequence_for<Args...>());
+                },
+                std::move(completer)
+        };
+    }
+
+    void remove(std::string_view name) {
+        auto it = commands.find(name);
+        if (it != commands.end())
+            commands.erase(it);
+    }
+
+    const Command *find(std::string_view name) const {
+        auto it = commands.find(name);
+        if (it == commands.end())
+            return nullptr;
+        return &it->second;
+    }
+
+    /**
+     * @return True if a command with the name of the given command was found and invoked
+     */
+    bool invoke(const ConsoleCommand &command, ConsoleOutput &output) const {
+        auto *cmd = find(command.cmd);
+        if (cmd == nullptr)
+            return false;
+        cmd->handler(command, output);
+        return true;
+    }
+
+    /**
+     * @param line The partially entered command line
+     * @return The sorted candidates for the last word of the line
+     */
+    std::vector<std::string> complete(std::string_view line) const {
+        std::vector<std::string> ret;
+        auto separator = line.find(' ');
+        if (separator == std::string_view::npos) {
+            for (auto &pair: commands) {
+                if (pair.first.compare(0, line.size(), line) == 0)
+                    ret.emplace_back(pair.first);
+            }
+        } else {
+            auto *cmd = find(line.substr(0, separator));
+            if (cmd == nullptr || !cmd->completer)
+                return {};
+            auto argument = std::count(line.begin(), line.end(), ' ') - 1;
+            auto prefix = line.substr(line.rfind(' ') + 1);
+            for (auto &candidate: cmd->completer(argument)) {
+                if (candidate.compare(0, prefix.size(), prefix) == 0)
+                    ret.emplace_back(candidate);
+            }
+        }
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    }
+
+    const auto &getCommands() const {
+        return commands;
+    }
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const {
+            return std::hash<std::string_view>()(str);
+        }
+    };
+
+    template<typename T>
+    struct OptionalArgument : std::false_type {
+        typedef T Type;
+    };
+
+    template<typename T>
+    struct OptionalArgument<std::optional<T>> : std::true_type {
+        typedef T Type;
+    };
+
+    template<typename... Args, size_t... I>
+    static std::string createUsage(const std::string &name,
+                                   const std::array<const char *, sizeof...(Args)> &argumentNames,
+                                   std::index_sequence<I...>) {
+        std::string ret = name;
+        ((ret += OptionalArgument<Args>::value
+                 ? std::string(" [") + argumentNames[I] + ":"
+                   + ArgumentParser<typename OptionalArgument<Args>::Type>::TYPE_NAME + "]"
+                 : std::string(" <") + argumentNames[I] + ":"
+                   + ArgumentParser<typename OptionalArgument<Args>::Type>::TYPE_NAME + ">"), ...);
+        return ret;
+    }
+
+    template<typename T>
+    static bool parseArgument(const std::vector<std::string> &arguments, size_t index, T &value) {
+        if constexpr (OptionalArgument<T>::value) {
+            if (index >= arguments.size())
+                return true;
+            typename OptionalArgument<T>::Type v;
+            if (!ArgumentParser<typename OptionalArgument<T>::Type>::parse(arguments.at(index), v))
+                return false;
+            value = std::move(v);
+            return true;
+        } else {
+            return index < arguments.size() && ArgumentParser<T>::parse(arguments.at(index), value);
+        }
+    }
+
+    template<typename... Args, typename F, size_t... I>
+    static void dispatch(const F &handler,
+                       const ConsoleCommand &command,
+                       ConsoleOutput &output,
+                       const std::string &usage,
+                       std::index_sequence<I...>) {
+        std::tuple<std::decay_t<Args>...> values;
+        if (command.arguments.size() > sizeof...(Args)
+            || !(parseArgument(command.arguments, I, std::get<I>(values)) && ...)) {
+            output.print("Usage: " + usage);
+            return;
+        }
+        handler(output, std::get<I>(values)...);
+    }
+
+    std::unordered_map<std::string, Command, NameHash, std::equal_to<>> commands;
+};
+
+#endif //FOXTROT_COMMANDREGISTRY_HPP
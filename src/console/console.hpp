@@ -22,11 +22,39 @@
 
 #include "consoleparser.hpp"
 #include "consoleoutput.hpp"
+#include "commandregistry.hpp"
 
 #include <set>
+#include <deque>
+#include <fstream>
+#include <filesystem>
 
 class Console : public ConsoleOutput {
 public:
+    Console() {
+        commands.add<std::optional<std::string>>("help", "List the commands or show the usage of a command", {"command"},
+                                                 [this](ConsoleOutput &output, const std::optional<std::string> &name) {
+                                                     printHelp(output, name);
+                                                 },
+                                                 [this](size_t argument) {
+                                                     return commands.complete("");
+                                                 });
+        commands.add<std::string>("exec", "Run the commands in the file, one per line", {"file"},
+                                  [this](ConsoleOutput &output, const std::string &file) {
+                                      if (!exec(file))
+                                          output.print("Failed to open " + file);
+                                  });
+        commands.add<std::optional<int>>("wait", "Delay the remaining script commands by a number of frames",
+                                         {"frames"},
+                                         [this](ConsoleOutput &output, std::optional<int> frames) {
+                                             waitFrames = std::max(1, frames.value_or(1));
+                                         });
+    }
+
+    CommandRegistry &getCommands() {
+        return commands;
+    }
+
     void addParser(ConsoleParser &parser) {
         parsers.insert(&parser);
     }
@@ -43,12 +71,58 @@ public:
         outputs.erase(&output);
     }
 
+    /**
+     * Queue the lines of the file before any remaining queued commands.
+     * Empty lines and lines starting with # are ignored.
+     *
+     * @return False if the file could not be opened
+     */
+    bool exec(const std::filesystem::path &file) {
+        std::ifstream stream(file);
+        if (!stream)
+            return false;
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(stream, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line[0] == '#')
+                continue;
+            lines.emplace_back(line);
+        }
+        queue.insert(queue.begin(), lines.begin(), lines.end());
+        return true;
+    }
+
+    /**
+     * Queue a command which is invoked on the next update.
+     */
+    void enqueueCommand(const std::string &command) {
+        queue.emplace_back(command);
+    }
+
+    /**
+     * Invoke the queued commands until the queue is empty or a wait command was invoked.
+     * Must be called once per frame.
+     */
+    void update() {
+        if (waitFrames > 0 && --waitFrames > 0)
+            return;
+        while (!queue.empty() && waitFrames == 0) {
+            auto command = std::move(queue.front());
+            queue.pop_front();
+            invokeCommand(command);
+        }
+    }
+
     void invokeCommand(const std::string &command) {
         invokeCommand(ConsoleCommand(command));
     }
 
     void invokeCommand(const ConsoleCommand &command) {
         print("> " + command.commandLine);
+        if (commands.invoke(command, *this))
+            return;
         for (auto &parser: parsers) {
             if (parser->parseCommand(command, *this))
                 return;
@@ -56,6 +130,22 @@ public:
         print("Command not found " + command.commandLine);
     }
 
+    /**
+     * @param line The partially entered command line
+     * @return The line with the last word completed up to the longest common prefix of the candidates
+     */
+    std::string complete(const std::string &line) const {
+        auto candidates = commands.complete(line);
+        if (candidates.empty())
+            return line;
+        auto prefix = candidates.front();
+        for (auto &candidate: candidates) {
+            prefix.resize(std::mismatch(prefix.begin(), prefix.end(), candidate.begin(), candidate.end()).first
+                          - prefix.begin());
+        }
+        return line.substr(0, line.rfind(' ') + 1) + prefix;
+    }
+
     void print(const std::string &str) override {
         for (auto &printer: outputs) {
             printer->print(str);
@@ -63,7 +153,28 @@ public:
     }
 
 private:
+    void printHelp(ConsoleOutput &output, const std::optional<std::string> &name) const {
+        if (name) {
+            auto *cmd = commands.find(*name);
+            if (cmd == nullptr) {
+                output.print("Command not found " + *name);
+            } else {
+                output.print(cmd->usage);
+                output.print("    " + cmd->help);
+            }
+        } else {
+            for (auto &n: commands.complete("")) {
+                auto *cmd = commands.find(n);
+                output.print(cmd->usage + " - " + cmd->help);
+            }
+        }
+    }
+
+    CommandRegistry commands;
     std::set<ConsoleParser *> parsers;
+
+    std::deque<std::string> queue; // The commands of scripts which have not been invoked yet
+    int waitFrames = 0;
     std::set<ConsoleOutput *> outputs;
 };
 
@@ -0,0 +1,112 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CONSOLELOG_HPP
+#define FOXTROT_CONSOLELOG_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+
+/**
+ * A fixed capacity ring buffer of console output lines.
+ *
+ * Lines are addressed by their sequence number which increases monotonically,
+ * once the capacity is reached the oldest line is overwritten and its sequence number becomes invalid.
+ */
+class ConsoleLog {
+public:
+    explicit ConsoleLog(size_t capacity) : lines(capacity) {
+        if (capacity == 0)
+            throw std::runtime_error("Console log capacity must be greater than zero");
+    }
+
+    /**
+     * Append the text, each newline character starts a new line.
+     */
+    void append(std::string_view text) {
+        size_t start = 0;
+        while (true) {
+            auto end = text.find('\n', start);
+            auto &line = lines[this->end % lines.size()];
+            // Assigning reuses the storage of the overwritten line
+            line.assign(text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+            this->end++;
+            if (this->end - begin > lines.size())
+                begin++;
+            if (end == std::string_view::npos)
+                break;
+            start = end + 1;
+        }
+    }
+
+    void clear() {
+        begin = end;
+    }
+
+    /**
+     * @return The sequence number of the oldest line
+     */
+    size_t getBegin() const {
+        return begin;
+    }
+
+    /**
+     * @return The sequence number after the newest line
+     */
+    size_t getEnd() const {
+        return end;
+    }
+
+    size_t getSize() const {
+        return end - begin;
+    }
+
+    size_t getCapacity() const {
+        return lines.size();
+    }
+
+    const std::string &at(size_t line) const {
+        if (line < begin || line >= end)
+            throw std::out_of_range("Console log line " + std::to_string(line) + " is not available");
+        return lines[line % lines.size()];
+    }
+
+    /**
+     * @param query
+     * @param before The sequence number before which to start searching
+     * @return The sequence number of the newest line before the given line which contains the query
+     */
+    std::optional<size_t> findBackward(std::string_view query, size_t before) const {
+        for (auto line = std::min(before, end); line > begin; line--) {
+            if (lines[(line - 1) % lines.size()].find(query) != std::string::npos)
+                return line - 1;
+        }
+        return {};
+    }
+
+private:
+    std::vector<std::string> lines;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+#endif //FOXTROT_CONSOLELOG_HPP
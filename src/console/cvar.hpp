@@ -0,0 +1,233 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CVAR_HPP
+#define FOXTROT_CVAR_HPP
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include "commandregistry.hpp"
+
+class CVarBase;
+
+/**
+ * The console variables of the application.
+ *
+ * Values written from the console are stored as pending and only become visible to the bound code
+ * when applyPending is called at the frame boundary.
+ */
+class CVarRegistry {
+public:
+    static CVarRegistry &getDefaultRegistry() {
+        static CVarRegistry registry;
+        return registry;
+    }
+
+    void add(CVarBase &var);
+
+    void remove(CVarBase &var);
+
+    CVarBase *find(std::string_view name) const {
+        auto it = vars.find(name);
+        if (it == vars.end())
+            return nullptr;
+        return it->second;
+    }
+
+    const std::map<std::string, CVarBase *, std::less<>> &getVars() const {
+        return vars;
+    }
+
+    /**
+     * Apply the values which have been set since the last call.
+     *
+     * @return True if any value has changed
+     */
+    bool applyPending();
+
+    /**
+     * Read "name value" lines from the file, unknown names and invalid values are ignored.
+     * The values are applied immediately.
+     */
+    void load(const std::filesystem::path &file);
+
+    void save(const std::filesystem::path &file) const;
+
+private:
+    CVarRegistry() = default;
+
+    std::map<std::string, CVarBase *, std::less<>> vars;
+};
+
+class CVarBase {
+public:
+    CVarBase(std::string name, std::string help)
+            : name(std::move(name)), help(std::move(help)) {
+        CVarRegistry::getDefaultRegistry().add(*this);
+    }
+
+    CVarBase(const CVarBase &other) = delete;
+
+    CVarBase &operator=(const CVarBase &other) = delete;
+
+    virtual ~CVarBase() {
+        CVarRegistry::getDefaultRegistry().remove(*this);
+    }
+
+    const std::string &getName() const {
+        return name;
+    }
+
+    const std::string &getHelp() const {
+        return help;
+    }
+
+    /**
+     * @return The number of times a new value has been applied, allows bound code to detect changes
+     */
+    size_t getModificationCount() const {
+        return modificationCount;
+    }
+
+    virtual std::string toString() const = 0;
+
+    /**
+     * @return The type and the valid range of the value
+     */
+    virtual std::string getDescription() const = 0;
+
+    /**
+     * Parse and validate the value and store it as pending.
+     *
+     * @return False if the value could not be parsed or is out of range
+     */
+    virtual bool set(std::string_view value) = 0;
+
+    /**
+     * @return True if a pending value was applied
+     */
+    virtual bool apply() = 0;
+
+protected:
+    size_t modificationCount = 0;
+
+private:
+    std::string name;
+    std::string help;
+};
+
+template<typename T>
+class CVar : public CVarBase {
+public:
+    CVar(std::string name, T defaultValue, T min, T max, std::string help)
+            : CVarBase(std::move(name), std::move(help)),
+              value(defaultValue),
+              min(min),
+              max(max) {}
+
+    const T &get() const {
+        return value;
+    }
+
+    bool set(const T &v) {
+        if (v < min || v > max)
+            return false;
+        pending = v;
+        return true;
+    }
+
+    bool set(std::string_view str) override {
+        T v;
+        return ArgumentParser<T>::parse(str, v) && set(v);
+    }
+
+    bool apply() override {
+        if (!pending)
+            return false;
+        bool changed = *pending != value;
+        value = *pending;
+        pending = {};
+        if (changed)
+            modificationCount++;
+        return changed;
+    }
+
+    std::string toString() const override {
+        std::stringstream stream;
+        stream << value;
+        return stream.str();
+    }
+
+    std::string getDescription() const override {
+        std::stringstream stream;
+        stream << ArgumentParser<T>::TYPE_NAME << " [" << min << ", " << max << "]";
+        return stream.str();
+    }
+
+private:
+    T value;
+    std::optional<T> pending;
+    T min;
+    T max;
+};
+
+inline void CVarRegistry::add(CVarBase &var) {
+    vars[var.getName()] = &var;
+}
+
+inline void CVarRegistry::remove(CVarBase &var) {
+    auto it = vars.find(var.getName());
+    if (it != vars.end() && it->second == &var)
+        vars.erase(it);
+}
+
+inline bool CVarRegistry::applyPending() {
+    bool changed = false;
+    for (auto &pair: vars) {
+        changed = pair.second->apply() || changed;
+    }
+    return changed;
+}
+
+inline void CVarRegistry::load(const std::filesystem::path &file) {
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line)) {
+        auto separator = line.find(' ');
+        if (line.empty() || line[0] == '#' || separator == std::string::npos)
+            continue;
+        auto *var = find(std::string_view(line).substr(0, separator));
+        if (var != nullptr && var->set(std::string_view(line).substr(separator + 1)))
+            var->apply();
+    }
+}
+
+inline void CVarRegistry::save(const std::filesystem::path &file) const {
+    std::ofstream stream(file);
+    for (auto &pair: vars) {
+        stream << pair.first << " " << pair.second->toString() << "\n";
+    }
+}
+
+#endif //FOXTROT_CVAR_HPP
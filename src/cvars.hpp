@@ -0,0 +1,87 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CVARS_HPP
+#define FOXTROT_CVARS_HPP
+
+#include "console/cvar.hpp"
+
+/**
+ * The tunable parameters of the game, persisted in the config file.
+ */
+namespace CVars {
+    inline CVar<int> frameCap("frame_cap", 144, 1, 1000,
+                              "The target frame rate");
+    inline CVar<bool> framePacer("frame_pacer", true, false, true,
+                                 "Pace the frames with a sleep followed by a spin instead of the engine frame limiter");
+    inline CVar<bool> frameLowLatency("frame_low_latency", false, false, true,
+                                      "Start the frames as late as possible before they are presented");
+    inline CVar<bool> frameCapRefresh("frame_cap_refresh", false, false, true,
+                                      "Lower the frame cap to a whole fraction of the display refresh rate");
+    inline CVar<float> fpsAlpha("fps_alpha", 0.9f, 0, 0.999f,
+                                "The smoothing factor of the average frame rate");
+
+    inline CVar<float> statsWindow("stats_window", 10, 1, 600,
+                                   "The seconds of frame times covered by the rolling percentiles");
+    inline CVar<bool> statsOverlay("stats_overlay", false, false, true,
+                                   "Show the frame time percentiles in place of the fps counter");
+
+    inline CVar<int> simRate("sim_rate", 120, 10, 1000,
+                             "The simulation steps per second, applied when a level is loaded");
+    inline CVar<int> simMaxSteps("sim_max_steps", 8, 1, 100,
+                                 "The maximum simulation steps per frame, the remaining frame time is dropped");
+
+    inline CVar<bool> schedulerVerify("sched_verify",
+#ifdef NDEBUG
+                                      false,
+#else
+                                      true,
+#endif
+                                      false, true,
+                                      "Run the scheduled systems sequentially and check their writes against the declared access");
+
+    inline CVar<int> physicsSubsteps("physics_substeps", 30, 1, 1000,
+                                     "The physics substeps, applied when a level is loaded");
+    inline CVar<float> physicsTimestep("physics_timestep", 1.0f / 300, 0.0001f, 0.1f,
+                                       "The physics timestep in seconds, applied when a level is loaded");
+    inline CVar<float> gravity("gravity", -20, -1000, 1000,
+                               "The vertical gravity of the physics world");
+
+    // Read by TimeSystem, which Level0 currently does not create
+    inline CVar<float> dayDuration("day_duration", 120, 1, 3600,
+                                   "The duration of the day in seconds");
+    inline CVar<float> nightDuration("night_duration", 180, 1, 3600,
+                                     "The duration of the night in seconds");
+    inline CVar<float> duskSpeed("dusk_speed", 1, 0.01f, 100,
+                                 "The speed of the transition between day and night");
+
+    inline CVar<int> revolverClipSize("revolver_clip_size", 9, 1, 1000,
+                                      "The number of rounds in a revolver clip");
+    inline CVar<float> revolverBulletSpread("revolver_bullet_spread", 5, 0, 180,
+                                            "The bullet spread of the revolver in degrees");
+
+    inline CVar<int> gatlingClipSize("gatling_clip_size", 300, 1, 10000,
+                                     "The number of rounds in a gatling clip");
+    inline CVar<float> gatlingRpm("gatling_rpm", 5000, 1, 100000,
+                                  "The maximum rounds per minute of the gatling");
+    inline CVar<float> gatlingBulletSpread("gatling_bullet_spread", 10, 0, 180,
+                                           "The bullet spread of the gatling in degrees");
+}
+
+#endif //FOXTROT_CVARS_HPP
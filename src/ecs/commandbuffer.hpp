@@ -0,0 +1,91 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_COMMANDBUFFER_HPP
+#define FOXTROT_COMMANDBUFFER_HPP
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * Collects the structural changes (creating and destroying entities) of systems run by a SystemScheduler,
+ * the scheduler applies them after all systems of the update have run.
+ *
+ * Systems which only record their structural changes here do not need structural access and can run concurrently
+ * with other systems. Commands may be recorded from any thread, they run in the order of recording on the thread
+ * applying the buffer while no system runs, so a command may access the state of the system which recorded it.
+ */
+class CommandBuffer {
+public:
+    typedef std::function<void(EntityScene &)> Command;
+
+    void record(Command command) {
+        std::lock_guard<std::mutex> guard(mutex);
+        commands.emplace_back(std::move(command));
+    }
+
+    /**
+     * @param init Invoked with the created entity to create its components
+     */
+    void create(std::function<void(Entity &)> init) {
+        record([init = std::move(init)](EntityScene &scene) {
+            auto entity = scene.createEntity();
+            init(entity);
+        });
+    }
+
+    void destroy(const EntityHandle &entity) {
+        record([entity](EntityScene &scene) {
+            scene.destroy(entity);
+        });
+    }
+
+    /**
+     * Run the recorded commands, commands recorded while applying run in the same call.
+     */
+    void apply(EntityScene &scene) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!commands.empty()) {
+            applying.swap(commands);
+            lock.unlock();
+            for (auto &command: applying) {
+                command(scene);
+            }
+            applying.clear();
+            lock.lock();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(mutex);
+        commands.clear();
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<Command> commands;
+    std::vector<Command> applying; // Keeps its capacity between updates
+};
+
+#endif //FOXTROT_COMMANDBUFFER_HPP
@@ -0,0 +1,67 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_COMPONENTUPDATES_HPP
+#define FOXTROT_COMPONENTUPDATES_HPP
+
+#include <tuple>
+#include <vector>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * Collects component updates while iterating a View and applies them to the scene afterwards.
+ *
+ * The buffers keep their capacity between frames so a steady state does not allocate.
+ */
+template<typename... Components>
+class ComponentUpdates {
+public:
+    template<typename T>
+    void update(const EntityHandle &entity, const T &component) {
+        std::get<std::vector<std::pair<EntityHandle, T>>>(updates).emplace_back(entity, component);
+    }
+
+    /**
+     * Apply the collected updates, in the order of Components and then in the order of collection.
+     */
+    void apply(EntityScene &scene) {
+        (applyPool<Components>(scene), ...);
+    }
+
+    void clear() {
+        (std::get<std::vector<std::pair<EntityHandle, Components>>>(updates).clear(), ...);
+    }
+
+private:
+    template<typename T>
+    void applyPool(EntityScene &scene) {
+        auto &pending = std::get<std::vector<std::pair<EntityHandle, T>>>(updates);
+        for (auto &pair: pending) {
+            scene.updateComponent(pair.first, pair.second);
+        }
+        pending.clear();
+    }
+
+    std::tuple<std::vector<std::pair<EntityHandle, Components>>...> updates;
+};
+
+#endif //FOXTROT_COMPONENTUPDATES_HPP
@@ -0,0 +1,257 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_COMPONENTVERSIONS_HPP
+#define FOXTROT_COMPONENTVERSIONS_HPP
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <typeindex>
+#include <cstdint>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * Version counters of the listed component types, per pool and per entity, maintained through the scene listener.
+ *
+ * Every create, update or destroy of a tracked component increments the version and stamps it on the pool and the
+ * entity. A system remembers getVersion() after its pass and asks changedSince with it on the next pass to skip
+ * work when its inputs did not change.
+ *
+ * Components which existed when attaching have the attach version, so asking for changes since version 0 reports
+ * every component. The engine notifies every updateComponent call, so writing an equal value also counts as a change.
+ *
+ * Optionally destroyed and renamed entities are logged as well, so that a consumer can apply all changes of the scene
+ * since a version without visiting the unchanged entities.
+ */
+template<typename... Components>
+class ComponentVersions : public EntityScene::Listener {
+public:
+    ComponentVersions() = default;
+
+    /**
+     * @param logEntities Log the destroyed and renamed entities, see forEachDestroyed and forEachRenamed.
+     * The log grows with every destroyed entity until discardEntityLog is called.
+     */
+    explicit ComponentVersions(bool logEntities)
+            : logEntities(logEntities) {}
+
+    ComponentVersions(const ComponentVersions &other) = delete;
+
+    ComponentVersions &operator=(const ComponentVersions &other) = delete;
+
+    ~ComponentVersions() override {
+        detach();
+    }
+
+    void attach(EntityScene &value) {
+        detach();
+        scene = &value;
+        scene->addListener(*this);
+        std::lock_guard<std::mutex> guard(mutex);
+        attachVersion = ++version;
+        for (auto &pool: pools) {
+            pool.version = attachVersion;
+            pool.entities.clear();
+        }
+        destroyed.clear();
+        renamed.clear();
+    }
+
+    void detach() {
+        if (scene != nullptr) {
+            scene->removeListener(*this);
+            scene = nullptr;
+        }
+    }
+
+    bool isAttached() const {
+        return scene != nullptr;
+    }
+
+    /**
+     * @return The current version, later changes have a greater version
+     */
+    uint64_t getVersion() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return version;
+    }
+
+    /**
+     * @return The version of the last change of any component of type T
+     */
+    template<typename T>
+    uint64_t getPoolVersion() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return pools.at(indexOf<T>()).version;
+    }
+
+    /**
+     * @return The version of the last change of the component of type T of the entity
+     */
+    template<typename T>
+    uint64_t getVersion(const EntityHandle &entity) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto &entities = pools.at(indexOf<T>()).entities;
+        auto it = entities.find(entity);
+        return it == entities.end() ? attachVersion : it->second;
+    }
+
+    template<typename T>
+    bool changedSince(uint64_t value) const {
+        return getPoolVersion<T>() > value;
+    }
+
+    template<typename T>
+    bool changedSince(const EntityHandle &entity, uint64_t value) const {
+        return getVersion<T>(entity) > value;
+    }
+
+    /**
+     * Invoke callback(entity) for the entities whose component of type T changed after the version.
+     *
+     * Only changes since attaching are visited, the scene must not be modified by the callback.
+     */
+    template<typename T, typename F>
+    void forEachChanged(uint64_t value, F &&callback) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &pair: pools.at(indexOf<T>()).entities) {
+            if (pair.second > value)
+                callback(pair.first);
+        }
+    }
+
+    /**
+     * Invoke callback(entity) for the entities destroyed after the version, requires logEntities.
+     */
+    template<typename F>
+    void forEachDestroyed(uint64_t value, F &&callback) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &pair: destroyed) {
+            if (pair.second > value)
+                callback(pair.first);
+        }
+    }
+
+    /**
+     * Invoke callback(entity) for the entities renamed after the version, requires logEntities.
+     */
+    template<typename F>
+    void forEachRenamed(uint64_t value, F &&callback) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &pair: renamed) {
+            if (pair.second > value)
+                callback(pair.first);
+        }
+    }
+
+    /**
+     * Drop the logged entities up to and including the version, once they have been visited.
+     */
+    void discardEntityLog(uint64_t value) {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::erase_if(destroyed, [value](const auto &pair) { return pair.second <= value; });
+        std::erase_if(renamed, [value](const auto &pair) { return pair.second <= value; });
+    }
+
+    void onEntityDestroy(const EntityHandle &entity) override {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &pool: pools) {
+            if (pool.entities.erase(entity) > 0) {
+                pool.version = ++version;
+            }
+        }
+        if (logEntities) {
+            renamed.erase(entity);
+            destroyed[entity] = ++version;
+        }
+    }
+
+    void onEntityNameChanged(const EntityHandle &entity,
+                             const std::string &newName,
+                             const std::string &oldName) override {
+        if (!logEntities)
+            return;
+        std::lock_guard<std::mutex> guard(mutex);
+        renamed[entity] = ++version;
+    }
+
+    void onComponentCreate(const EntityHandle &entity, const Component &component) override {
+        stamp(entity, component.getType());
+    }
+
+    void onComponentDestroy(const EntityHandle &entity, const Component &component) override {
+        stamp(entity, component.getType());
+    }
+
+    void onComponentUpdate(const EntityHandle &entity,
+                           const Component &oldComponent,
+                           const Component &newComponent) override {
+        stamp(entity, newComponent.getType());
+    }
+
+private:
+    static constexpr size_t NONE = sizeof...(Components);
+
+    struct Pool {
+        uint64_t version = 0;
+        std::map<EntityHandle, uint64_t> entities;
+    };
+
+    template<typename T>
+    static constexpr size_t indexOf() {
+        size_t ret = NONE;
+        size_t i = 0;
+        ((std::is_same_v<T, Components> ? ret = i : 0, i++), ...);
+        static_assert(((std::is_same_v<T, Components>) || ...), "The component type is not tracked");
+        return ret;
+    }
+
+    static size_t indexOf(const std::type_index &type) {
+        size_t ret = NONE;
+        size_t i = 0;
+        ((type == std::type_index(typeid(Components)) ? ret = i : 0, i++), ...);
+        return ret;
+    }
+
+    void stamp(const EntityHandle &entity, const std::type_index &type) {
+        auto index = indexOf(type);
+        if (index == NONE)
+            return;
+        std::lock_guard<std::mutex> guard(mutex);
+        auto &pool = pools.at(index);
+        pool.version = ++version;
+        pool.entities[entity] = version;
+    }
+
+    EntityScene *scene = nullptr;
+    bool logEntities = false;
+
+    mutable std::mutex mutex;
+    uint64_t version = 0;
+    uint64_t attachVersion = 0;
+    std::array<Pool, sizeof...(Components)> pools;
+    std::map<EntityHandle, uint64_t> destroyed;
+    std::map<EntityHandle, uint64_t> renamed;
+};
+
+#endif //FOXTROT_COMPONENTVERSIONS_HPP
@@ -0,0 +1,121 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_NAMEDENTITY_HPP
+#define FOXTROT_NAMEDENTITY_HPP
+
+#include "xng/xng.hpp"
+
+#include "ecs/symboltable.hpp"
+
+using namespace xng;
+
+/**
+ * A cached handle to the entity with a given name.
+ *
+ * The name is resolved on the first get after attaching and the handle is then reused until the entity is destroyed
+ * or renamed, or another entity is given the name, which is detected through the scene listener callbacks.
+ * While no entity has the name the lookup is only repeated after entities were created or renamed.
+ */
+class NamedEntity : public EntityScene::Listener {
+public:
+    explicit NamedEntity(std::string_view name)
+            : symbol(SymbolTable::getDefaultTable().intern(name)) {}
+
+    NamedEntity(const NamedEntity &other) = delete;
+
+    NamedEntity &operator=(const NamedEntity &other) = delete;
+
+    ~NamedEntity() override {
+        detach();
+    }
+
+    void attach(EntityScene &value) {
+        detach();
+        scene = &value;
+        scene->addListener(*this);
+        invalidate();
+    }
+
+    void detach() {
+        if (scene != nullptr) {
+            scene->removeListener(*this);
+            scene = nullptr;
+        }
+        invalidate();
+    }
+
+    /**
+     * @return The handle of the entity or a null handle if no entity in the attached scene has the name
+     */
+    EntityHandle get() {
+        if (!resolved) {
+            if (scene == nullptr)
+                throw std::runtime_error("Named entity " + getName() + " is not attached to a scene");
+            auto &name = getName();
+            handle = scene->entityNameExists(name) ? scene->getEntityByName(name) : EntityHandle();
+            resolved = true;
+        }
+        return handle;
+    }
+
+    void setName(std::string_view name) {
+        symbol = SymbolTable::getDefaultTable().intern(name);
+        invalidate();
+    }
+
+    const std::string &getName() const {
+        return SymbolTable::getDefaultTable().getName(symbol);
+    }
+
+    Symbol getSymbol() const {
+        return symbol;
+    }
+
+    void onEntityCreate(const EntityHandle &entity) override {
+        // The name of a created entity may be assigned after the creation callback
+        if (!handle)
+            invalidate();
+    }
+
+    void onEntityDestroy(const EntityHandle &entity) override {
+        if (entity == handle)
+            invalidate();
+    }
+
+    void onEntityNameChanged(const EntityHandle &entity,
+                             const std::string &newName,
+                             const std::string &oldName) override {
+        if (entity == handle || SymbolTable::getDefaultTable().find(newName) == symbol)
+            invalidate();
+    }
+
+private:
+    void invalidate() {
+        handle = {};
+        resolved = false;
+    }
+
+    Symbol symbol;
+    EntityScene *scene = nullptr;
+    EntityHandle handle;
+    bool resolved = false;
+};
+
+#endif //FOXTROT_NAMEDENTITY_HPP
@@ -0,0 +1,93 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_SYMBOLTABLE_HPP
+#define FOXTROT_SYMBOLTABLE_HPP
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * An interned name, symbols of equal names compare equal.
+ */
+typedef uint32_t Symbol;
+
+/**
+ * Interns names as small integer symbols so that names can be compared and stored without string operations.
+ *
+ * Symbols and the strings returned by getName stay valid for the lifetime of the table.
+ */
+class SymbolTable {
+public:
+    static constexpr Symbol NONE = 0; // The symbol of the empty name
+
+    static SymbolTable &getDefaultTable() {
+        static SymbolTable table;
+        return table;
+    }
+
+    SymbolTable() {
+        names.emplace_back();
+    }
+
+    Symbol intern(std::string_view name) {
+        if (name.empty())
+            return NONE;
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = symbols.find(name);
+        if (it != symbols.end())
+            return it->second;
+        auto symbol = static_cast<Symbol>(names.size());
+        auto &stored = names.emplace_back(name);
+        symbols.emplace(stored, symbol);
+        return symbol;
+    }
+
+    /**
+     * @return The symbol of the name or NONE if the name was never interned
+     */
+    Symbol find(std::string_view name) const {
+        if (name.empty())
+            return NONE;
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = symbols.find(name);
+        if (it == symbols.end())
+            return NONE;
+        return it->second;
+    }
+
+    const std::string &getName(Symbol symbol) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (symbol >= names.size())
+            throw std::runtime_error("Invalid symbol " + std::to_string(symbol));
+        return names.at(symbol);
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::deque<std::string> names; // Deque to keep the returned references valid while interning
+    std::map<std::string_view, Symbol, std::less<>> symbols; // Views into names
+};
+
+#endif //FOXTROT_SYMBOLTABLE_HPP
@@ -0,0 +1,140 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_VIEW_HPP
+#define FOXTROT_VIEW_HPP
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * The component types an entity must not have to be visited by a View.
+ */
+template<typename... Excluded>
+struct Exclude {
+    template<typename T>
+    static constexpr bool contains = (std::is_same_v<T, Excluded> || ...);
+};
+
+/**
+ * Visits the entities which have all the Components and none of the Excluded components.
+ *
+ * The pool with the fewest components drives the iteration and the components of the other pools are looked up once
+ * per visited entity with a single find, the callback receives the entity and a reference to each component in the order
+ * of Components.
+ *
+ * As with iterating a pool directly, components of the viewed types must not be created or updated while visiting
+ * because any of the pools may drive the iteration. Collect the updates in ComponentUpdates and apply them afterwards.
+ */
+template<typename Exclusion, typename... Components>
+class View;
+
+template<typename... Excluded, typename... Components>
+class View<Exclude<Excluded...>, Components...> {
+public:
+    static_assert(sizeof...(Components) > 0, "A view requires at least one component type");
+
+    explicit View(const EntityScene &scene)
+            : scene(scene) {}
+
+    /**
+     * @param callback Invoked as callback(entity, components...), returning false stops the iteration
+     */
+    template<typename F>
+    void each(F &&callback) const {
+        std::array<size_t, sizeof...(Components)> sizes{scene.template getPool<Components>().size()...};
+        auto driver = static_cast<size_t>(std::min_element(sizes.begin(), sizes.end()) - sizes.begin());
+        eachFrom(driver, callback, std::index_sequence_for<Components...>());
+    }
+
+    /**
+     * @return The number of entities visited by each
+     */
+    size_t count() const {
+        size_t ret = 0;
+        each([&ret](const EntityHandle &, const Components &...) { ret++; });
+        return ret;
+    }
+
+private:
+    template<typename F, size_t... Indices>
+    void eachFrom(size_t driver, F &callback, std::index_sequence<Indices...>) const {
+        ((Indices == driver ? (drive<Indices>(callback), true) : false) || ...);
+    }
+
+    template<size_t Index, typename F>
+    void drive(F &callback) const {
+        using Driver = std::tuple_element_t<Index, std::tuple<Components...>>;
+        for (auto &pair: scene.template getPool<Driver>()) {
+            auto &entity = pair.first;
+            std::tuple<const Components *...> found;
+            if (!((std::get<const Components *>(found) = find<Components, Driver>(entity, pair.second)) && ...)
+                || ((find<Excluded, Driver>(entity, pair.second) != nullptr) || ...)) {
+                continue;
+            }
+            if constexpr (std::is_same_v<std::invoke_result_t<F &, const EntityHandle &, const Components &...>, bool>) {
+                if (!callback(entity, *std::get<const Components *>(found)...))
+                    return;
+            } else {
+                callback(entity, *std::get<const Components *>(found)...);
+            }
+        }
+    }
+
+    /**
+     * @return The component of the entity or null, with a single lookup in the pool
+     */
+    template<typename T, typename Driver>
+    const T *find(const EntityHandle &entity, const Driver &driven) const {
+        if constexpr (std::is_same_v<T, Driver>) {
+            return &driven;
+        } else {
+            auto &pool = scene.template getPool<T>();
+            auto it = pool.find(entity);
+            return it == pool.end() ? nullptr : &it->second;
+        }
+    }
+
+    const EntityScene &scene;
+};
+
+/**
+ * Create a view of the entities in the scene which have all the Components.
+ */
+template<typename... Components>
+View<Exclude<>, Components...> view(const EntityScene &scene) {
+    return View<Exclude<>, Components...>(scene);
+}
+
+/**
+ * Create a view of the entities in the scene which have all the Components and none of the Excluded components.
+ */
+template<typename... Components, typename... Excluded>
+View<Exclude<Excluded...>, Components...> view(const EntityScene &scene, Exclude<Excluded...>) {
+    return View<Exclude<Excluded...>, Components...>(scene);
+}
+
+#endif //FOXTROT_VIEW_HPP
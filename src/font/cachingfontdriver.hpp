@@ -0,0 +1,211 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CACHINGFONTDRIVER_HPP
+#define FOXTROT_CACHINGFONTDRIVER_HPP
+
+#include <array>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+
+#include "xng/xng.hpp"
+
+#include "util/bytestreambuf.hpp"
+
+using namespace xng;
+
+/**
+ * A font driver which shares fonts with identical data and the glyphs rasterized from them.
+ *
+ * Fonts are identified by a hash of their data, fonts created from a uri are additionally keyed by the uri
+ * so that the data of a resource is hashed only once. The returned fonts rasterize a given pixel size only once,
+ * subsequent requests for the same pixel size, from any font object created with the same data, return the cached glyphs.
+ * This allows the console TextRenderer and the CanvasRenderSystem of each level to share glyphs.
+ */
+class CachingFontDriver : public FontDriver {
+public:
+    explicit CachingFontDriver(FontDriver &driver)
+            : driver(driver) {}
+
+    /**
+     * The engine only hands over a stream, the data is hashed while reading it in chunks
+     * and the stream is rewound for the wrapped driver if the font is not cached yet.
+     *
+     * @param data A seekable stream of the font data
+     * @return
+     */
+    std::unique_ptr<Font> createFont(std::istream &data) override {
+        auto start = data.tellg();
+        if (start == std::istream::pos_type(-1)) {
+            throw std::runtime_error("Font streams must be seekable");
+        }
+
+        uint64_t hash = fnvOffset;
+        size_t size = 0;
+        std::array<char, 4096> chunk{};
+        while (data.read(chunk.data(), chunk.size()) || data.gcount() > 0) {
+            auto count = static_cast<size_t>(data.gcount());
+            hash = fnv(hash, std::as_bytes(std::span(chunk.data(), count)));
+            size += count;
+        }
+        data.clear();
+        data.seekg(start);
+
+        auto key = std::make_pair(hash, size);
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = fonts.find(key);
+        if (it == fonts.end()) {
+            auto entry = std::make_shared<Entry>();
+            entry->font = driver.createFont(data);
+            it = fonts.emplace(key, std::move(entry)).first;
+        }
+        return std::make_unique<SharedFont>(it->second);
+    }
+
+    /**
+     * Create a font from the given data without copying it.
+     *
+     * @param data The font data, only read during the call
+     * @return
+     */
+    std::unique_ptr<Font> createFont(std::span<const std::byte> data) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return std::make_unique<SharedFont>(getEntry(data));
+    }
+
+    /**
+     * Create a font from the raw resource at the given uri.
+     * The resource is only loaded and hashed the first time the uri is requested.
+     *
+     * @param uri The uri of a RawResource containing the font data
+     * @return
+     */
+    std::unique_ptr<Font> createFont(const Uri &uri) {
+        auto key = uri.toString();
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto it = uris.find(key);
+            if (it != uris.end()) {
+                return std::make_unique<SharedFont>(it->second);
+            }
+        }
+
+        ResourceHandle<RawResource> resource(uri);
+        auto &bytes = resource.get().bytes;
+
+        std::lock_guard<std::mutex> guard(mutex);
+        auto entry = getEntry(std::as_bytes(std::span(bytes)));
+        uris[key] = entry;
+        return std::make_unique<SharedFont>(entry);
+    }
+
+    /**
+     * @return The number of distinct fonts held by the cache
+     */
+    size_t getFontCount() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return fonts.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(mutex);
+        fonts.clear();
+        uris.clear();
+    }
+
+private:
+    struct Entry {
+        std::mutex mutex;
+        std::unique_ptr<Font> font;
+        std::map<std::pair<int, int>, std::map<char, Character>> glyphs;
+
+        // Map nodes are stable and never erased, the reference stays valid for the lifetime of the entry.
+        const std::map<char, Character> &renderAscii(const Vec2i &pixelSize) {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto key = std::make_pair(pixelSize.x, pixelSize.y);
+            auto it = glyphs.find(key);
+            if (it == glyphs.end()) {
+                font->setPixelSize(pixelSize);
+                it = glyphs.emplace(key, font->renderAscii()).first;
+            }
+            return it->second;
+        }
+    };
+
+    class SharedFont : public Font {
+    public:
+        explicit SharedFont(std::shared_ptr<Entry> entry)
+                : entry(std::move(entry)) {}
+
+        void setPixelSize(Vec2i size) override {
+            pixelSize = size;
+        }
+
+        // The Font interface returns the glyphs by value, this is the only copy made of the cached glyphs.
+        std::map<char, Character> renderAscii() override {
+            return entry->renderAscii(pixelSize);
+        }
+
+        const std::map<char, Character> &getGlyphs() const {
+            return entry->renderAscii(pixelSize);
+        }
+
+    private:
+        std::shared_ptr<Entry> entry;
+        Vec2i pixelSize;
+    };
+
+    // The cache mutex must be held by the caller
+    std::shared_ptr<Entry> getEntry(std::span<const std::byte> data) {
+        auto key = std::make_pair(fnv(fnvOffset, data), data.size());
+
+        auto it = fonts.find(key);
+        if (it != fonts.end()) {
+            return it->second;
+        }
+
+        ByteStreamBuf buf(data);
+        std::istream stream(&buf);
+
+        auto entry = std::make_shared<Entry>();
+        entry->font = driver.createFont(stream);
+        fonts[key] = entry;
+        return entry;
+    }
+
+    static constexpr uint64_t fnvOffset = 14695981039346656037ull;
+
+    // FNV-1a, continued from the given hash
+    static uint64_t fnv(uint64_t hash, std::span<const std::byte> data) {
+        for (auto &b: data) {
+            hash ^= static_cast<uint64_t>(b);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    FontDriver &driver;
+
+    std::mutex mutex;
+    std::map<std::pair<uint64_t, size_t>, std::shared_ptr<Entry>> fonts;
+    std::map<std::string, std::shared_ptr<Entry>> uris;
+};
+
+#endif //FOXTROT_CACHINGFONTDRIVER_HPP
@@ -20,87 +20,172 @@
 #ifndef FOXTROT_FOXTROT_HPP
 #define FOXTROT_FOXTROT_HPP
 
+#include <iomanip>
+
 #include "xng/xng.hpp"
 
+#include "resource/assets.hpp"
+
 #include "levels/mainmenu.hpp"
 #include "levels/level0.hpp"
 
 #include "console/console.hpp"
+#include "console/consolelog.hpp"
+
+#include "cvars.hpp"
+
+#include "font/cachingfontdriver.hpp"
+
+#include "resource/hotreloader.hpp"
+#include "resource/cachingparser.hpp"
 
 #include "levelloader.hpp"
 
+#include "util/taskgraph.hpp"
+#include "util/framepacer.hpp"
+
+#include "profile/profiler.hpp"
+#include "profile/allocationtracker.hpp"
+
+#include "stats/frametimerecorder.hpp"
+
 #include "events/loadlevelevent.hpp"
 
 using namespace xng;
 
-class Foxtrot : public Application, public EventListener, public ConsoleOutput, public ConsoleParser {
+class Foxtrot : public Application,
+                public EventListener,
+                public ConsoleOutput,
+                public HotReloader::Listener {
 public:
     Foxtrot(int argc, char *argv[]) : Application(argc, argv),
                                       archive(std::filesystem::current_path().append("assets").string()),
-                                      displayDriver(),
-                                      gpuDriver(),
-                                      window(displayDriver.createWindow(xng::OPENGL_4_6)),
-                                      renderDevice(gpuDriver.createRenderDevice()),
-                                      screenTarget(window->getRenderTarget(*renderDevice)),
-                                      ren2d(*renderDevice,
-                                            shaderCompiler,
-                                            shaderDecompiler),
                                       eventBus(std::make_shared<EventBus>()),
-                                      levelLoader(*screenTarget,
-                                                  ren2d,
-                                                  *window,
-                                                  fontDriver,
-                                                  physicsDriver,
-                                                  *audioDevice,
-                                                  eventBus) {
-        REGISTER_COMPONENT(BackdropComponent)
-        REGISTER_COMPONENT(CharacterControllerComponent)
-        REGISTER_COMPONENT(FloorComponent)
-        REGISTER_COMPONENT(FpsComponent)
-        REGISTER_COMPONENT(HealthComponent)
-        REGISTER_COMPONENT(InputComponent)
-        REGISTER_COMPONENT(PlayerComponent)
-
-        auto parsers = std::vector<std::unique_ptr<ResourceParser>>();
-        parsers.emplace_back(std::make_unique<JsonParser>());
-        parsers.emplace_back(std::make_unique<StbiParser>());
-        parsers.emplace_back(std::make_unique<SndFileParser>());
-
-        ResourceRegistry::getDefaultRegistry().setImporter(ResourceImporter(std::move(parsers)));
-        ResourceRegistry::getDefaultRegistry().addArchive("file", std::make_shared<DirectoryArchive>(archive));
-        ResourceRegistry::getDefaultRegistry().setDefaultScheme("file");
-
-        ResourceHandle<RawResource> fontAsset(Uri("fonts/Space_Mono/SpaceMono-Regular.ttf"));
-
-        std::string str = std::string(fontAsset.get().bytes.begin(), fontAsset.get().bytes.end());
-        std::stringstream stream(str);
-        consoleFont = fontDriver.createFont(stream);
-
-        consoleTextRenderer = std::make_unique<TextRenderer>(*consoleFont, ren2d, Vec2i(0, 25));
+                                      decodeCache(std::make_shared<DecodeCache>(
+                                              std::filesystem::current_path().append("cache"),
+                                              DECODE_CACHE_SIZE)),
+                                      fontCache(fontDriver),
+                                      hotReloader(std::filesystem::current_path().append("assets"), *this) {
+        for (int i = 1; i < argc; i++) {
+            if (std::string(argv[i]) == "--headless") {
+                headless = true;
+            } else if (std::string(argv[i]) == "--frametimes-csv" && i < argc - 1) {
+                frameTimesCsv = argv[++i];
+            }
+        }
+
+        Profiler::getDefaultProfiler().setThreadName("Main");
+
+        // The resources of the main menu are loaded on the thread pool while the window and renderer are created.
+        TaskGraph startup;
+        startup.add("components", {}, []() {
+            REGISTER_COMPONENT(BackdropComponent)
+            REGISTER_COMPONENT(CharacterControllerComponent)
+            REGISTER_COMPONENT(FloorComponent)
+            REGISTER_COMPONENT(FpsComponent)
+            REGISTER_COMPONENT(HealthComponent)
+            REGISTER_COMPONENT(InputComponent)
+            REGISTER_COMPONENT(PlayerComponent)
+        }, TaskGraph::MAIN_THREAD);
+        startup.add("resources", {}, [this]() {
+            auto parsers = std::vector<std::unique_ptr<ResourceParser>>();
+            parsers.emplace_back(std::make_unique<JsonParser>());
+            parsers.emplace_back(std::make_unique<CachingParser>(std::make_unique<StbiParser>(), decodeCache));
+            parsers.emplace_back(std::make_unique<CachingParser>(std::make_unique<SndFileParser>(), decodeCache));
+
+            ResourceRegistry::getDefaultRegistry().setImporter(ResourceImporter(std::move(parsers)));
+            ResourceRegistry::getDefaultRegistry().addArchive("file", std::make_shared<DirectoryArchive>(archive));
+            ResourceRegistry::getDefaultRegistry().setDefaultScheme("file");
+        });
+        // The scheduler graphs of the levels are only built when a level is loaded, an invalid graph fails here instead
+        startup.add("schedulers", {}, []() {
+            Level0::checkSimulationGraph();
+        });
+        startup.add("prefetch", {"components", "resources"}, [this]() {
+            sceneCache.getTemplate(LEVEL_MAIN_MENU, Assets::uri(ASSET_SCENES_MENU_JSON));
+        });
+        // When running headless no window, render device or audio device is created and the frontend stays null
+        startup.add("window", {}, [this]() {
+            if (headless)
+                return;
+            window = displayDriver.createWindow(xng::OPENGL_4_6);
+            renderDevice = gpuDriver.createRenderDevice();
+            screenTarget = window->getRenderTarget(*renderDevice);
+            refreshRate = displayDriver.getPrimaryMonitor()->getVideoMode().refreshRate;
+        }, TaskGraph::MAIN_THREAD);
+        startup.add("renderer", {"window"}, [this]() {
+            if (headless)
+                return;
+            ren2d = std::make_unique<Renderer2D>(*renderDevice, shaderCompiler, shaderDecompiler);
+            ren2d->renderClear(*screenTarget,
+                               ColorRGBA::black(),
+                               {},
+                               screenTarget->getDescription().size);
+            window->swapBuffers();
+            window->update();
+
+            frontend.window = window.get();
+            frontend.target = screenTarget.get();
+            frontend.ren2d = ren2d.get();
+            frontend.audioDevice = audioDevice.get();
+        }, TaskGraph::MAIN_THREAD);
+        startup.add("levels", {"renderer", "resources"}, [this]() {
+            levelLoader = std::make_unique<LevelLoader>(frontend,
+                                                        fontCache,
+                                                        physicsDriver,
+                                                        sceneCache,
+                                                        eventBus,
+                                                        console.getCommands());
+        }, TaskGraph::MAIN_THREAD);
+        startup.run();
+
+        // Written to the console log, it is only printed to stdout when running headless
+        for (auto &node: startup.getNodes()) {
+            print("Startup " + node.name + ": "
+                  + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    node.start - startup.getOrigin()).count())
+                  + "ms - "
+                  + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    node.end - startup.getOrigin()).count())
+                  + "ms");
+        }
 
         console.addOutput(*this);
-        console.addParser(*this);
+        registerCommands();
 
         eventBus->addListener(*this);
-        ren2d.renderClear(*screenTarget,
-                          ColorRGBA::black(),
-                          {},
-                          screenTarget->getDescription().size);
-        window->swapBuffers();
-        window->update();
-
-        frameLimiter.setTargetFrameRate(144);
+
+        CVarRegistry::getDefaultRegistry().load(getConfigPath());
+        applyFrameCap();
+
+        // The autoexec script runs first followed by the scripts passed with --exec, starting with the first frame
+        if (std::filesystem::exists(std::filesystem::current_path().append("autoexec.cfg"))) {
+            console.enqueueCommand("exec autoexec.cfg");
+        }
+        for (int i = 1; i < argc - 1; i++) {
+            if (std::string(argv[i]) == "--exec") {
+                console.enqueueCommand("exec " + std::string(argv[++i]));
+            }
+        }
     }
 
     ~Foxtrot() override {
+        if (headless) {
+            std::cout << "Headless " << frontend.headlessStats.toString() << std::endl;
+        }
+        if (!frameTimesCsv.empty()) {
+            FrameTimeRecorder::getDefaultRecorder().writeCsv(frameTimesCsv);
+        }
+        CVarRegistry::getDefaultRegistry().save(getConfigPath());
         eventBus->removeListener(*this);
     }
 
     void onEvent(const Event &event) override {
+        ProfileZone zone("Foxtrot event", "event");
         if (event.getEventType() == typeid(LoadLevelEvent)) {
             auto &ev = event.as<LoadLevelEvent>();
             currentLevel = ev.name;
-            levelLoader.loadLevel(ev.name);
+            levelLoader->loadLevel(ev.name);
         } else if (event.getEventType() == typeid(KeyboardEvent)) {
             auto kbev = event.as<KeyboardEvent>();
             if (kbev.type == xng::KeyboardEvent::KEYBOARD_KEY_DOWN) {
@@ -108,6 +193,8 @@ public:
                 switch (key) {
                     case KEY_F5:
                         ResourceRegistry::getDefaultRegistry().reloadAllResources();
+                        sceneCache.clear();
+                        fontCache.clear();
                         break;
                     case KEY_BACKSPACE:
                         if (!consoleInput.empty())
@@ -117,8 +204,16 @@ public:
                         console.invokeCommand(consoleInput);
                         consoleInput = "";
                         break;
+                    case KEY_TAB:
+                        if (consoleOpen) {
+                            consoleInput = console.complete(consoleInput);
+                        }
+                        break;
                     case KEY_F12:
                         consoleOpen = !consoleOpen;
+                        if (consoleOpen && !consoleTextRenderer) {
+                            createConsoleRenderer();
+                        }
                         break;
                 }
             } else if (kbev.type == xng::KeyboardEvent::KEYBOARD_CHARACTER_INPUT) {
@@ -131,56 +226,427 @@ public:
         }
     }
 
-    void print(const std::string &str) override {
-        consoleOutput += str + "\n";
-    }
+    void onAssetsChanged(const std::set<std::string> &files) override {
+        bool reloadLevel = false;
+        size_t scenes = 0;
+
+        for (auto &file: files) {
+            // Scenes are only parsed into their template so changes to them do not require a registry reload
+            for (auto &pair: sceneCache.getEntries()) {
+                if (pair.second.uri.toString() == file) {
+                    scenes++;
+                    sceneCache.evict(pair.first);
+                    reloadLevel = reloadLevel || pair.first == currentLevel;
+                }
+            }
+        }
 
-    bool parseCommand(const ConsoleCommand &command, ConsoleOutput &printer) override {
-        const std::map<std::string, std::function<void()>> commands = {
-                {"loadlevel",   [this, &command]() {
-                    levelLoader.loadLevel(parseLevelID(command.arguments.at(0)));
-                }},
-                {"reloadlevel", [this]() {
-                    levelLoader.loadLevel(currentLevel);
-                }},
-                {"fps",         [this, &printer]() {
-                    printer.print(std::to_string(fpsAverage));
-                }},
-        };
+        if (reloadLevel) {
+            levelLoader->loadLevel(currentLevel);
+        }
 
-        auto it = commands.find(command.cmd);
-        if (it != commands.end()) {
-            it->second();
-            return true;
-        } else {
-            return false;
+        if (scenes > 0) {
+            print("Reloaded " + std::to_string(scenes) + " modified scenes");
+        }
+
+        // The engine registry can not reload individual resources, a handle to an already loaded uri returns the
+        // cached data, so modified resources are only reported instead of reloading the whole registry on every save.
+        if (files.size() > scenes) {
+            print(std::to_string(files.size() - scenes) + " modified resources, press F5 to reload all resources");
+        }
+    }
+
+    void print(const std::string &str) override {
+        consoleLog.append(str);
+        // There is no console to read the output from when running headless
+        if (headless) {
+            std::cout << str << std::endl;
         }
     }
 
 protected:
     void start() override {
-        levelLoader.loadLevel(LEVEL_MAIN_MENU);
+        currentLevel = LEVEL_MAIN_MENU;
+        levelLoader->loadLevel(currentLevel);
     }
 
     void stop() override {}
 
     void update(DeltaTime deltaTime) override {
+        framePacer.beginFrame();
+
+        ProfileZone zone("Frame");
+
+        FrameTimeRecorder::getDefaultRecorder().update(std::chrono::duration_cast<FrameTimeRecorder::Clock::duration>(
+                std::chrono::duration<float>(CVars::statsWindow.get())));
+        if (deltaTime > 0) {
+            FrameTimeRecorder::getDefaultRecorder().record(FrameTimeRecorder::FRAME,
+                                                           std::chrono::duration_cast<FrameTimeRecorder::Clock::duration>(
+                                                                   std::chrono::duration<float>(deltaTime)));
+        }
+
+        // Joined first so that the console commands, cvar values and asset reloads applied below
+        // do not race with the simulation systems, which are started again by the level update
+        levelLoader->awaitSimulation();
+
+        console.update();
+
+        // Values set from the console since the last frame become visible to the levels and systems here
+        if (CVarRegistry::getDefaultRegistry().applyPending()) {
+            applyFrameCap();
+        }
+
         fps = deltaTime > 0 ? 1.0f / deltaTime : 0;
+        auto fpsAlpha = CVars::fpsAlpha.get();
         fpsAverage = fpsAlpha * fpsAverage + (1.0f - fpsAlpha) * fps;
-        ren2d.renderClear(*screenTarget,
-                          ColorRGBA::yellow(),
-                          {},
-                          screenTarget->getDescription().size);
-        levelLoader.update(deltaTime);
+        if (!headless) {
+            ren2d->renderClear(*screenTarget,
+                               ColorRGBA::yellow(),
+                               {},
+                               screenTarget->getDescription().size);
+        }
+        hotReloader.update();
+        levelLoader->update(deltaTime);
+        if (!firstFrameReported && levelLoader->getState() == LevelLoader::STATE_RUNNING) {
+            reportFirstFrame();
+        }
         if (consoleOpen) {
             updateConsole(deltaTime);
         }
         Application::update(deltaTime);
+
+        AllocationTracker::getDefaultTracker().endFrame();
+
+        framePacer.endFrame();
     }
 
 private:
-    LevelID parseLevelID(const std::string &id) {
-        return (LevelID) std::stoi(id);
+    static const uintmax_t DECODE_CACHE_SIZE = 512 * 1024 * 1024;
+    static const size_t CONSOLE_LOG_CAPACITY = 1000;
+
+    /**
+     * Print the time from construction until the first frame of the first level was drawn,
+     * which is the first frame accepting input.
+     */
+    void reportFirstFrame() {
+        firstFrameReported = true;
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime);
+        auto str = "Time to first interactive frame: " + std::to_string(duration.count()) + "ms"
+                   + " (decode cache " + std::to_string(decodeCache->getHits()) + " hits, "
+                   + std::to_string(decodeCache->getMisses()) + " misses)";
+        print(str);
+    }
+
+    /**
+     * Headless runs are not limited by the frame cap so that they measure the simulation cost alone.
+     *
+     * When the frame pacer is used the engine frame limiter is disabled,
+     * otherwise the pacer only records the frame intervals for comparison.
+     */
+    void applyFrameCap() {
+        framePacer.setLowLatency(CVars::frameLowLatency.get());
+        if (headless) {
+            frameLimiter.setTargetFrameRate(std::numeric_limits<int>::max());
+            framePacer.setTargetFrameRate(0);
+        } else if (CVars::framePacer.get()) {
+            frameLimiter.setTargetFrameRate(std::numeric_limits<int>::max());
+            framePacer.setTargetFrameRate(getTargetFrameRate());
+        } else {
+            frameLimiter.setTargetFrameRate(getTargetFrameRate());
+            framePacer.setTargetFrameRate(0);
+        }
+    }
+
+    /**
+     * @return The frame cap, lowered to a whole fraction of the refresh rate if frame_cap_refresh is set
+     * so that every frame is shown for the same number of refreshes.
+     */
+    int getTargetFrameRate() const {
+        auto cap = CVars::frameCap.get();
+        if (CVars::frameCapRefresh.get() && refreshRate > 0) {
+            auto divisor = (refreshRate + cap - 1) / cap;
+            return refreshRate / divisor;
+        }
+        return cap;
+    }
+
+    // The console font is only loaded when the console is opened for the first time
+    void createConsoleRenderer() {
+        consoleFont = fontCache.createFont(Assets::uri(ASSET_FONTS_SPACE_MONO_SPACEMONO_REGULAR_TTF));
+        consoleTextRenderer = std::make_unique<TextRenderer>(*consoleFont, *ren2d, Vec2i(0, 25));
+    }
+
+    static std::filesystem::path getConfigPath() {
+        return std::filesystem::current_path().append("foxtrot.cfg");
+    }
+
+    void registerCommands() {
+        auto &commands = console.getCommands();
+        auto levelCompleter = [](size_t argument) -> std::vector<std::string> {
+            return {std::to_string(LEVEL_MAIN_MENU), std::to_string(LEVEL_ZERO)};
+        };
+
+        commands.add<LevelID>("loadlevel", "Load the level with the given id", {"level"},
+                              [this](ConsoleOutput &output, LevelID level) {
+                                  currentLevel = level;
+                                  levelLoader->loadLevel(currentLevel);
+                              },
+                              levelCompleter);
+        commands.add("reloadlevel", "Load a new instance of the current level", {},
+                     [this](ConsoleOutput &output) {
+                         levelLoader->loadLevel(currentLevel);
+                     });
+        commands.add<std::optional<std::string>>("find", "Scroll the console to the previous line containing the text",
+                                                 {"text"},
+                                                 [this](ConsoleOutput &output, const std::optional<std::string> &text) {
+                                                     searchConsole(text);
+                                                 });
+        commands.add("clear", "Clear the console output", {},
+                     [this](ConsoleOutput &output) {
+                         consoleLog.clear();
+                         consoleScroll = 0;
+                         consoleSearchMatch = {};
+                     });
+        commands.add<std::optional<std::string>, std::optional<std::string>>(
+                "cvar", "List the console variables, print one or set its value for the next frame",
+                {"name", "value"},
+                [](ConsoleOutput &output,
+                   const std::optional<std::string> &name,
+                   const std::optional<std::string> &value) {
+                    auto &registry = CVarRegistry::getDefaultRegistry();
+                    if (!name) {
+                        for (auto &pair: registry.getVars()) {
+                            output.print(pair.first + " " + pair.second->toString());
+                        }
+                        return;
+                    }
+                    auto *var = registry.find(*name);
+                    if (var == nullptr) {
+                        output.print("Unknown cvar " + *name);
+                    } else if (!value) {
+                        output.print(var->getName() + " " + var->toString() + " " + var->getDescription());
+                        output.print("    " + var->getHelp());
+                    } else if (!var->set(*value)) {
+                        output.print("Invalid value " + *value + " for " + var->getName() + " " + var->getDescription());
+                    }
+                },
+                [](size_t argument) {
+                    std::vector<std::string> ret;
+                    if (argument == 0) {
+                        for (auto &pair: CVarRegistry::getDefaultRegistry().getVars()) {
+                            ret.emplace_back(pair.first);
+                        }
+                    }
+                    return ret;
+                });
+        commands.add("quit", "Exit the application", {},
+                     [this](ConsoleOutput &output) {
+                         shutdown = true;
+                     });
+        commands.add("savecfg", "Write the console variables to the config file", {},
+                     [](ConsoleOutput &output) {
+                         CVarRegistry::getDefaultRegistry().save(getConfigPath());
+                     });
+        commands.add("fps", "Print the average frames per second", {},
+                     [this](ConsoleOutput &output) {
+                         output.print(std::to_string(fpsAverage));
+                     });
+        commands.add<std::optional<std::string>>("pacing", "Print the frame pacing statistics or reset them",
+                                                 {"reset"},
+                                                 [this](ConsoleOutput &output, const std::optional<std::string> &arg) {
+                                                     if (arg == "reset") {
+                                                         framePacer.resetStatistics();
+                                                         return;
+                                                     }
+                                                     auto stats = framePacer.getStatistics();
+                                                     std::stringstream stream;
+                                                     stream << std::fixed << std::setprecision(3)
+                                                            << "Target " << getTargetFrameRate() << " fps"
+                                                            << " (refresh " << refreshRate << " Hz), "
+                                                            << stats.frames << " frames, interval "
+                                                            << stats.meanInterval << "ms, jitter "
+                                                            << stats.jitter << "ms, max deviation "
+                                                            << stats.maxDeviation << "ms, "
+                                                            << stats.lateFrames << " late, sleep overshoot "
+                                                            << stats.sleepOvershoot << "ms, predicted work "
+                                                            << stats.predictedWork << "ms";
+                                                     output.print(stream.str());
+                                                 },
+                                                 [](size_t argument) -> std::vector<std::string> {
+                                                     return {"reset"};
+                                                 });
+        commands.add<std::string, std::optional<std::string>>(
+                "profile", "Start recording profiler zones or stop and write them as a Chrome trace",
+                {"start|stop", "file"},
+                [this](ConsoleOutput &output, const std::string &action, const std::optional<std::string> &file) {
+                    if (file) {
+                        profileFile = *file;
+                    }
+                    if (action == "start") {
+                        Profiler::getDefaultProfiler().start();
+                        output.print("Profiling started");
+                    } else if (action == "stop") {
+                        auto count = Profiler::getDefaultProfiler().stop(profileFile);
+                        output.print("Wrote " + std::to_string(count) + " zones to " + profileFile);
+                    } else {
+                        output.print("Invalid action " + action);
+                    }
+                },
+                [](size_t argument) -> std::vector<std::string> {
+                    if (argument == 0)
+                        return {"start", "stop"};
+                    return {};
+                });
+        commands.add<std::optional<std::string>, std::optional<std::string>>(
+                "frametimes", "Print the recent frame time percentiles, all since the last reset, reset or write a csv",
+                {"all|reset|csv", "file"},
+                [](ConsoleOutput &output, const std::optional<std::string> &action, const std::optional<std::string> &file) {
+                    auto &recorder = FrameTimeRecorder::getDefaultRecorder();
+                    if (action == "reset") {
+                        recorder.reset();
+                    } else if (action == "csv") {
+                        auto path = file.value_or("frametimes.csv");
+                        recorder.writeCsv(path);
+                        output.print("Wrote " + path);
+                    } else if (!action || action == "all") {
+                        for (size_t i = 0; i < FrameTimeRecorder::CHANNEL_COUNT; i++) {
+                            auto summary = recorder.getSummary(static_cast<FrameTimeRecorder::Channel>(i), !action);
+                            std::stringstream stream;
+                            stream << std::fixed << std::setprecision(2)
+                                   << FrameTimeRecorder::CHANNEL_NAMES[i] << ": "
+                                   << summary.count << " samples, p50 " << summary.p50
+                                   << "ms, p95 " << summary.p95
+                                   << "ms, p99 " << summary.p99
+                                   << "ms, p99.9 " << summary.p999
+                                   << "ms, max " << summary.max << "ms";
+                            output.print(stream.str());
+                        }
+                    } else {
+                        output.print("Invalid action " + *action);
+                    }
+                },
+                [](size_t argument) -> std::vector<std::string> {
+                    if (argument == 0)
+                        return {"all", "reset", "csv"};
+                    return {};
+                });
+        commands.add<std::optional<std::string>>(
+                "allocs", "Print the allocations of the last frame per system, enable, disable or reset tracking or assert an allocation free steady state",
+                {"on|off|reset|assert|noassert"},
+                [](ConsoleOutput &output, const std::optional<std::string> &action) {
+                    auto &tracker = AllocationTracker::getDefaultTracker();
+                    if (!AllocationTracker::isAvailable()) {
+                        output.print("Allocation tracking requires a build with TRACK_ALLOCATIONS");
+                    } else if (action == "on") {
+                        tracker.setEnabled(true);
+                    } else if (action == "off") {
+                        tracker.setEnabled(false);
+                    } else if (action == "reset") {
+                        tracker.reset();
+                    } else if (action == "assert") {
+                        tracker.setEnabled(true);
+                        tracker.setAssert(true);
+                        output.print("Allocations by systems now abort the process");
+                    } else if (action == "noassert") {
+                        tracker.setAssert(false);
+                    } else if (!action) {
+                        if (!AllocationTracker::isEnabled()) {
+                            output.print("Allocation tracking is disabled");
+                            return;
+                        }
+                        auto &last = tracker.getLastFrame();
+                        auto &total = tracker.getTotal();
+                        auto frames = std::max<uint64_t>(tracker.getFrames(), 1);
+                        output.print("Last frame " + std::to_string(last.allocations) + " allocations ("
+                                     + std::to_string(last.bytes) + " bytes) " + std::to_string(tracker.getLastFrameFrees())
+                                     + " frees, average " + std::to_string(total.allocations / frames) + " allocations ("
+                                     + std::to_string(total.bytes / frames) + " bytes) over "
+                                     + std::to_string(tracker.getFrames()) + " frames");
+                        for (auto *scope: tracker.getScopes()) {
+                            if (scope->total.allocations == 0)
+                                continue;
+                            output.print(scope->name + ": " + std::to_string(scope->lastFrame.allocations) + " ("
+                                         + std::to_string(scope->lastFrame.bytes) + " bytes), average "
+                                         + std::to_string(scope->total.allocations / frames) + " ("
+                                         + std::to_string(scope->total.bytes / frames) + " bytes)");
+                        }
+                    } else {
+                        output.print("Invalid action " + *action);
+                    }
+                },
+                [](size_t argument) -> std::vector<std::string> {
+                    return {"on", "off", "reset", "assert", "noassert"};
+                });
+        commands.add("headless", "Print the work submitted to the null frontend", {},
+                     [this](ConsoleOutput &output) {
+                         if (headless) {
+                             output.print(frontend.headlessStats.toString());
+                         } else {
+                             output.print("Not running headless");
+                         }
+                     });
+        commands.add<std::optional<std::string>>("scenecache", "Print, clear or evict (by level id) scene templates",
+                                                 {"clear|level"},
+                                                 [this](ConsoleOutput &output, const std::optional<std::string> &arg) {
+                                                     LevelID level;
+                                                     if (!arg) {
+                                                         for (auto &pair: sceneCache.getEntries()) {
+                                                             output.print(std::to_string(pair.first)
+                                                                          + " " + pair.second.uri.toString()
+                                                                          + " " + std::to_string(pair.second.size)
+                                                                          + " bytes");
+                                                         }
+                                                         output.print("Total "
+                                                                      + std::to_string(sceneCache.getMemoryUsage())
+                                                                      + " bytes");
+                                                     } else if (*arg == "clear") {
+                                                         sceneCache.clear();
+                                                     } else if (ArgumentParser<LevelID>::parse(*arg, level)) {
+                                                         sceneCache.evict(level);
+                                                     } else {
+                                                         output.print("Invalid level id " + *arg);
+                                                     }
+                                                 },
+                                                 [levelCompleter](size_t argument) {
+                                                     auto ret = levelCompleter(argument);
+                                                     ret.emplace_back("clear");
+                                                     return ret;
+                                                 });
+        commands.add<std::optional<size_t>>("residency", "Print the resident bytes by type or set the budget in MiB",
+                                            {"budget"},
+                                            [this](ConsoleOutput &output, std::optional<size_t> budget) {
+                                                auto &residency = levelLoader->getResidency();
+                                                if (budget) {
+                                                    residency.setBudget(*budget * 1024 * 1024);
+                                                }
+                                                for (auto &pair: residency.getResidentBytes()) {
+                                                    output.print(pair.first + " " + std::to_string(pair.second)
+                                                                 + " bytes");
+                                                }
+                                                output.print("Total " + std::to_string(residency.getTotalBytes())
+                                                             + " / " + std::to_string(residency.getBudget())
+                                                             + " bytes, "
+                                                             + std::to_string(residency.getUnreferencedCount())
+                                                             + " unreferenced assets");
+                                            });
+        commands.add<std::optional<std::string>>("decodecache", "Print the decode cache statistics or clear it",
+                                                 {"clear"},
+                                                 [this](ConsoleOutput &output, const std::optional<std::string> &arg) {
+                                                     if (arg == "clear") {
+                                                         decodeCache->clear();
+                                                     } else {
+                                                         output.print(std::to_string(decodeCache->getSize())
+                                                                      + " bytes, "
+                                                                      + std::to_string(decodeCache->getHits())
+                                                                      + " hits, "
+                                                                      + std::to_string(decodeCache->getMisses())
+                                                                      + " misses");
+                                                     }
+                                                 },
+                                                 [](size_t argument) -> std::vector<std::string> {
+                                                     return {"clear"};
+                                                 });
     }
 
     void updateConsole(DeltaTime deltaTime) {
@@ -193,19 +659,21 @@ private:
         auto inputPos = Vec2f(0, outputSize.y + inputSize.y / 2 + spacingBetweenInputOutput);
         auto outputPos = Vec2f();
 
-        ren2d.renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
-        ren2d.draw(Rectf(outputPos, conSize), ColorRGBA::gray(1, 225));
-        ren2d.renderPresent();
+        ren2d->renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
+        ren2d->draw(Rectf(outputPos, conSize), ColorRGBA::gray(1, 225));
+        ren2d->renderPresent();
 
         updateConsoleInput(inputPos, inputSize);
-        updateConsoleOutput(deltaTime, outputPos, outputSize);
+        updateConsoleOutput(outputPos, outputSize);
     }
 
     void updateConsoleInput(Vec2f inputPos, const Vec2f &inputSize) {
         if (renderedConsoleInput != consoleInput) {
             renderedConsoleInput = consoleInput;
             auto inputText = consoleTextRenderer->render("> " + consoleInput, TextLayout{.lineHeight = 20});
-            inputTextHandle = ren2d.createTexture(inputText.getImage());
+            if (inputTextHandle.size.x > 0)
+                ren2d->destroyTexture(inputTextHandle);
+            inputTextHandle = ren2d->createTexture(inputText.getImage());
         }
 
         const auto padding = 25;
@@ -213,102 +681,141 @@ private:
         inputPos.x += padding;
         inputPos.y -= padding;
 
-        ren2d.renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
+        ren2d->renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
 
         auto textSize = inputTextHandle.size.convert<float>();
 
         if (textSize.x + padding * 2 > inputSize.x) {
             auto diff = textSize.x - inputSize.x;
-            ren2d.draw(Rectf({-(textSize.x * consoleInputScroll) + diff + padding, 0}, {inputSize.x, textSize.y}),
-                       Rectf({inputPos.x - padding, inputPos.y}, {inputSize.x, textSize.y}),
-                       inputTextHandle,
-                       {},
-                       0,
-                       NEAREST,
-                       ColorRGBA::white());
+            ren2d->draw(Rectf({-(textSize.x * consoleInputScroll) + diff + padding, 0}, {inputSize.x, textSize.y}),
+                        Rectf({inputPos.x - padding, inputPos.y}, {inputSize.x, textSize.y}),
+                        inputTextHandle,
+                        {},
+                        0,
+                        NEAREST,
+                        ColorRGBA::white());
         } else {
-            ren2d.draw(Rectf({}, textSize),
-                       Rectf(inputPos, textSize),
-                       inputTextHandle,
-                       {},
-                       0,
-                       NEAREST,
-                       ColorRGBA::white());
+            ren2d->draw(Rectf({}, textSize),
+                        Rectf(inputPos, textSize),
+                        inputTextHandle,
+                        {},
+                        0,
+                        NEAREST,
+                        ColorRGBA::white());
         }
 
-        ren2d.renderPresent();
+        ren2d->renderPresent();
     }
 
-    void updateConsoleOutput(DeltaTime deltaTime, Vec2f outputPos, const Vec2f &outputSize) {
-        Vec2f textSize;
-        if (!consoleOutput.empty()) {
-            const auto padding = 15;
-
-            if (renderedConsoleOutput != consoleOutput) {
-                renderedConsoleOutput = consoleOutput;
-                auto outputText = consoleTextRenderer->render(consoleOutput,
-                                                              TextLayout{.lineHeight = 20,
-                                                                      .lineWidth = (int) outputSize.x - padding * 2,
-                                                                      .alignment = xng::TEXT_ALIGN_LEFT});
-                outputTextHandle = ren2d.createTexture(outputText.getImage());
-            }
-
-            textSize = outputTextHandle.size.convert<float>();
+    /**
+     * Draw the log lines which fit into the output area, starting at the newest line minus the scroll offset.
+     * Each line is laid out once and its texture is cached while the line is near the visible window.
+     */
+    void updateConsoleOutput(Vec2f outputPos, const Vec2f &outputSize) {
+        const auto padding = 15;
+        const auto cacheMargin = 64;
+
+        auto lineWidth = (int) outputSize.x - padding * 2;
+        if (lineWidth != consoleLineWidth) {
+            destroyConsoleLineTextures();
+            consoleLineWidth = lineWidth;
+        }
 
-            auto displaySize = outputSize;
+        if (consoleLog.getSize() == 0) {
+            consoleScroll = 0;
+        } else {
+            consoleScroll = std::min(consoleScroll, consoleLog.getSize() - 1);
+        }
 
-            displaySize.x -= padding * 2;
-            outputPos.x += padding;
+        ren2d->renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
+
+        auto bottom = consoleLog.getEnd() - consoleScroll;
+        auto line = bottom;
+        float y = outputSize.y;
+        while (line > consoleLog.getBegin() && y > 0) {
+            line--;
+            auto &texture = getConsoleLineTexture(line);
+            auto size = texture.size.convert<float>();
+            y -= size.y;
+
+            // Clip the topmost line to the output area
+            auto clip = y < 0 ? -y : 0;
+            ren2d->draw(Rectf({0, clip}, {size.x, size.y - clip}),
+                        Rectf({outputPos.x + padding, outputPos.y + y + clip}, {size.x, size.y - clip}),
+                        texture,
+                        {},
+                        0,
+                        NEAREST,
+                        consoleSearchMatch == line ? ColorRGBA::yellow() : ColorRGBA::white());
+        }
 
-            ren2d.renderBegin(*screenTarget, false, {}, {}, screenTarget->getDescription().size, {});
+        ren2d->renderPresent();
 
-            if (displaySize.y < outputSize.y) {
-                auto diff = outputSize.y - displaySize.y;
-                outputPos.y += diff;
-                ren2d.draw(Rectf({}, displaySize),
-                           Rectf(outputPos, displaySize),
-                           outputTextHandle,
-                           {},
-                           0,
-                           NEAREST,
-                           ColorRGBA::white());
+        // Release the layouts of lines far from the visible window and of lines which have been overwritten
+        for (auto it = consoleLineTextures.begin(); it != consoleLineTextures.end();) {
+            if (it->first + cacheMargin < line || it->first >= bottom + cacheMargin
+                || it->first < consoleLog.getBegin()) {
+                ren2d->destroyTexture(it->second);
+                it = consoleLineTextures.erase(it);
             } else {
-                auto diff = textSize.y - outputSize.y;
-                ren2d.draw(Rectf({0, -(textSize.y * consoleOutputScroll) + diff}, displaySize),
-                           Rectf(outputPos, displaySize),
-                           outputTextHandle,
-                           {},
-                           0,
-                           NEAREST,
-                           ColorRGBA::white());
+                it++;
             }
-
-            ren2d.renderPresent();
         }
 
+        const size_t scrollLines = 3;
         if (window->getInput().getMouse().wheelDelta.y > 0) {
-            consoleScrollUp(deltaTime, textSize, outputSize);
+            consoleScroll += scrollLines;
         } else if (window->getInput().getMouse().wheelDelta.y < 0) {
-            consoleScrollDown(deltaTime, textSize);
+            consoleScroll = consoleScroll > scrollLines ? consoleScroll - scrollLines : 0;
         }
     }
 
-    void consoleScrollDown(DeltaTime deltaTime, const Vec2f &textSize) {
-        if (consoleOutputScroll <= 0)
-            consoleOutputScroll = 0;
-        else
-            consoleOutputScroll -= (1000 / textSize.y) * deltaTime;
+    TextureAtlasHandle &getConsoleLineTexture(size_t line) {
+        auto it = consoleLineTextures.find(line);
+        if (it == consoleLineTextures.end()) {
+            auto &text = consoleLog.at(line);
+            auto image = consoleTextRenderer->render(text.empty() ? " " : text,
+                                                     TextLayout{.lineHeight = 20,
+                                                             .lineWidth = consoleLineWidth,
+                                                             .alignment = xng::TEXT_ALIGN_LEFT}).getImage();
+            it = consoleLineTextures.emplace(line, ren2d->createTexture(image)).first;
+        }
+        return it->second;
     }
 
-    void consoleScrollUp(DeltaTime deltaTime, const Vec2f &textSize, const Vec2f &outputSize) {
-        float diff = textSize.y > outputSize.y ? outputSize.y / textSize.y : textSize.y / outputSize.y;
-        float maxScroll = 1 - diff;
-        if (consoleOutputScroll >= maxScroll)
-            consoleOutputScroll = maxScroll;
-        else
-            consoleOutputScroll += (1000 / textSize.y) * deltaTime;
+    void destroyConsoleLineTextures() {
+        for (auto &pair: consoleLineTextures) {
+            ren2d->destroyTexture(pair.second);
+        }
+        consoleLineTextures.clear();
     }
 
+    /**
+     * Scroll to the next older line containing the query, the log is searched in place.
+     */
+    void searchConsole(const std::optional<std::string> &query) {
+        // The echo of the search command itself is never a match
+        auto before = consoleLog.getEnd() - 1;
+        if (query) {
+            consoleSearch = *query;
+            before -= std::min(consoleScroll, consoleLog.getSize() - 1);
+        } else if (consoleSearchMatch && *consoleSearchMatch >= consoleLog.getBegin()) {
+            before = *consoleSearchMatch;
+        }
+
+        consoleSearchMatch = consoleSearch.empty()
+                             ? std::nullopt
+                             : consoleLog.findBackward(consoleSearch, before);
+        if (consoleSearchMatch) {
+            consoleScroll = consoleLog.getEnd() - 1 - *consoleSearchMatch;
+        } else {
+            print("No match for " + consoleSearch);
+        }
+    }
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    bool firstFrameReported = false;
+
     freetype::FtFontDriver fontDriver;
     shaderc::ShaderCCompiler shaderCompiler;
     spirv_cross::SpirvCrossDecompiler shaderDecompiler;
@@ -323,37 +830,57 @@ private:
 
     std::unique_ptr<AudioDevice> audioDevice;
 
+    bool headless = false; // Set by --headless
+
+    FramePacer framePacer;
+
+    std::string profileFile = "profile.json"; // The trace file written by "profile stop"
+
+    std::string frameTimesCsv; // Set by --frametimes-csv, the frame time histograms are written to it on exit
+    int refreshRate = 0; // The refresh rate of the primary monitor, 0 if unknown
+    Frontend frontend; // Null when running headless
+
     DirectoryArchive archive;
-    Renderer2D ren2d;
+    std::unique_ptr<Renderer2D> ren2d;
     std::shared_ptr<EventBus> eventBus;
 
-    LevelLoader levelLoader;
+    std::shared_ptr<DecodeCache> decodeCache; // Shared by the image and audio parsers
 
-    Console console;
+    CachingFontDriver fontCache; // Shared by the console and the canvas render systems of the levels
+
+    SceneTemplateCache sceneCache; // Filled on the thread pool during startup
+
+    Console console; // Outlives the level loader which removes the commands of the running level
+
+    std::unique_ptr<LevelLoader> levelLoader;
+
+    HotReloader hotReloader;
 
     std::string consoleInput;
-    std::string consoleOutput;
+    ConsoleLog consoleLog{CONSOLE_LOG_CAPACITY};
+    std::map<size_t, TextureAtlasHandle> consoleLineTextures; // The cached layouts by line sequence number
+    int consoleLineWidth = 0; // The line width of the cached layouts
+    size_t consoleScroll = 0; // The number of lines scrolled up from the newest line
+
+    std::string consoleSearch;
+    std::optional<size_t> consoleSearchMatch;
 
     std::unique_ptr<Font> consoleFont;
     std::unique_ptr<TextRenderer> consoleTextRenderer;
 
     TextureAtlasHandle inputTextHandle;
-    TextureAtlasHandle outputTextHandle;
 
     std::string renderedConsoleInput;
-    std::string renderedConsoleOutput;
 
     float consoleInputScroll = 0;
-    float consoleOutputScroll = 0;
 
     bool consoleOpen = false;
 
     float fps = 0;
 
     float fpsAverage = 0;
-    float fpsAlpha = 0.9;
 
-    LevelID currentLevel;
+    LevelID currentLevel = LEVEL_NULL;
 };
 
 #endif //FOXTROT_FOXTROT_HPP
@@ -0,0 +1,57 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_FRONTEND_HPP
+#define FOXTROT_FRONTEND_HPP
+
+#include "xng/xng.hpp"
+
+#include "headless/headlessstats.hpp"
+
+using namespace xng;
+
+/**
+ * The window, render and audio objects used by the levels.
+ *
+ * When running headless all of them are null, the levels then leave out the systems which draw,
+ * play audio or read window input and add the null systems which only count the submitted work instead.
+ */
+struct Frontend {
+    Window *window = nullptr;
+    RenderTarget *target = nullptr;
+    Renderer2D *ren2d = nullptr;
+    AudioDevice *audioDevice = nullptr;
+
+    Vec2i headlessViewportSize = {1920, 1080}; // The viewport size used by the camera when running headless
+
+    HeadlessStats headlessStats;
+
+    bool isHeadless() const {
+        return window == nullptr;
+    }
+
+    Vec2i getViewportSize() const {
+        if (target == nullptr)
+            return headlessViewportSize;
+        else
+            return target->getDescription().size;
+    }
+};
+
+#endif //FOXTROT_FRONTEND_HPP
@@ -0,0 +1,42 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_HEADLESSSTATS_HPP
+#define FOXTROT_HEADLESSSTATS_HPP
+
+#include <string>
+
+/**
+ * The work submitted to the null render and audio systems while running headless.
+ */
+struct HeadlessStats {
+    size_t frames = 0;
+    size_t sprites = 0;
+    size_t texts = 0;
+    size_t sounds = 0;
+
+    std::string toString() const {
+        return std::to_string(frames) + " frames, "
+               + std::to_string(sprites) + " sprites, "
+               + std::to_string(texts) + " texts, "
+               + std::to_string(sounds) + " sounds";
+    }
+};
+
+#endif //FOXTROT_HEADLESSSTATS_HPP
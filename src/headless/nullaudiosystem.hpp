@@ -0,0 +1,60 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_NULLAUDIOSYSTEM_HPP
+#define FOXTROT_NULLAUDIOSYSTEM_HPP
+
+#include <set>
+
+#include "xng/xng.hpp"
+
+#include "headless/headlessstats.hpp"
+
+using namespace xng;
+
+/**
+ * Replaces the AudioSystem when running headless, counts the audio sources which start playing.
+ */
+class NullAudioSystem : public System {
+public:
+    explicit NullAudioSystem(HeadlessStats &stats)
+            : stats(stats) {}
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        playing.clear();
+    }
+
+    void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        std::set<EntityHandle> current;
+        for (auto &pair: scene.getPool<AudioSourceComponent>()) {
+            if (pair.second.play) {
+                current.insert(pair.first);
+                if (playing.find(pair.first) == playing.end())
+                    stats.sounds++;
+            }
+        }
+        playing = std::move(current);
+    }
+
+private:
+    HeadlessStats &stats;
+    std::set<EntityHandle> playing;
+};
+
+#endif //FOXTROT_NULLAUDIOSYSTEM_HPP
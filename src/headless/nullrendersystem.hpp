@@ -0,0 +1,53 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_NULLRENDERSYSTEM_HPP
+#define FOXTROT_NULLRENDERSYSTEM_HPP
+
+#include "xng/xng.hpp"
+
+#include "headless/headlessstats.hpp"
+
+using namespace xng;
+
+/**
+ * Replaces the CanvasRenderSystem when running headless, counts the sprites and texts which would have been drawn.
+ */
+class NullRenderSystem : public System {
+public:
+    explicit NullRenderSystem(HeadlessStats &stats)
+            : stats(stats) {}
+
+    void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        for (auto &pair: scene.getPool<SpriteComponent>()) {
+            if (pair.second.enabled)
+                stats.sprites++;
+        }
+        for (auto &pair: scene.getPool<TextComponent>()) {
+            if (pair.second.enabled)
+                stats.texts++;
+        }
+        stats.frames++;
+    }
+
+private:
+    HeadlessStats &stats;
+};
+
+#endif //FOXTROT_NULLRENDERSYSTEM_HPP
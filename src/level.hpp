@@ -20,10 +20,18 @@
 #ifndef FOXTROT_LEVEL_HPP
 #define FOXTROT_LEVEL_HPP
 
+#include <algorithm>
+
 #include "xng/xng.hpp"
 
 #include "levelname.hpp"
 
+#include "resource/residencyset.hpp"
+
+#include "profile/profiledsystem.hpp"
+
+#include "console/commandregistry.hpp"
+
 class Level {
 public:
     class LoadListener {
@@ -39,11 +47,20 @@ public:
 
     virtual LevelID getID() = 0;
 
-    // Loading interface
+    /**
+     * @return The assets which should be kept resident while the level is loaded
+     */
+    virtual ResidencySet getResidencySet() { return {}; }
+
+    // Loading interface, the listener may be invoked from a worker thread
     virtual void startLoad(LoadListener &listener) { listener.onLoadFinish(getID()); };
 
     virtual void awaitLoad() {};
 
+    /**
+     * Release the resources of the level after onStop has been called.
+     * Invoked from a worker thread so implementations must not access the render device or the event bus.
+     */
     virtual void unload() {};
 
     // Lifecycle interface
@@ -51,7 +68,35 @@ public:
 
     virtual void onUpdate(xng::DeltaTime deltaTime) {};
 
+    /**
+     * Wait for the work the level runs concurrently to the main thread such as its simulation steps.
+     * Until the next onUpdate the caller may then modify state which is read by the systems of the level.
+     */
+    virtual void awaitSimulation() {};
+
     virtual void onStop() {};
+
+    /**
+     * Register the console commands of the level, invoked on the main thread after onStart.
+     * The level loader removes the added commands before onStop so they may capture the level.
+     * Commands of the application must not be replaced.
+     */
+    virtual void registerCommands(CommandRegistry &commands) {};
+
+protected:
+    /**
+     * Create a frame pipeline of the given systems, null systems are left out.
+     * This allows levels to omit the systems which are unavailable when running headless.
+     *
+     * The systems are wrapped to record their updates in the profiler.
+     */
+    static xng::SystemPipeline createPipeline(std::vector<std::shared_ptr<xng::System>> systems) {
+        systems.erase(std::remove(systems.begin(), systems.end(), nullptr), systems.end());
+        for (auto &system: systems) {
+            system = std::make_shared<ProfiledSystem>(system);
+        }
+        return xng::SystemPipeline(xng::SystemPipeline::TICK_FRAME, systems);
+    }
 };
 
 #endif //FOXTROT_LEVEL_HPP
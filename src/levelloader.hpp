@@ -20,36 +20,56 @@
 #ifndef FOXTROT_LEVELLOADER_HPP
 #define FOXTROT_LEVELLOADER_HPP
 
+#include <atomic>
+#include <list>
+#include <set>
+
 #include "xng/xng.hpp"
 
+#include "scenetemplatecache.hpp"
+#include "frontend.hpp"
+#include "resource/resourceresidency.hpp"
+
+#include "console/commandregistry.hpp"
+
+#include "profile/profiler.hpp"
+
 using namespace xng;
 
 class LevelLoader : Level::LoadListener {
 public:
-    LevelLoader(RenderTarget &target,
-                Renderer2D &ren2d,
-                Window &window,
+    enum State {
+        STATE_IDLE, // No level has been requested yet or the last load failed
+        STATE_LOADING, // The current level is loading in the background
+        STATE_RUNNING, // The current level has been started and is updated every frame
+    };
+
+    LevelLoader(Frontend &frontend,
                 FontDriver &fontDriver,
                 PhysicsDriver &physicsDriver,
-                AudioDevice &audioDevice,
-                std::shared_ptr<EventBus> eventBus)
-            : target(target),
-              ren2d(ren2d),
-              window(window),
+                SceneTemplateCache &sceneCache,
+                std::shared_ptr<EventBus> eventBus,
+                CommandRegistry &commands)
+            : frontend(frontend),
               fontDriver(fontDriver),
               physicsDriver(physicsDriver),
-              audioDevice(audioDevice),
-              eventBus(std::move(eventBus)) {}
+              sceneCache(sceneCache),
+              eventBus(std::move(eventBus)),
+              commands(commands) {}
 
     ~LevelLoader() {
         if (currentLevel) {
             currentLevel->awaitLoad();
-            currentLevel->onStop();
+            if (state == STATE_RUNNING) {
+                removeLevelCommands();
+                currentLevel->onStop();
+            }
+            currentLevel->unload();
         }
-        if (nextLevel) {
-            nextLevel->awaitLoad();
-            nextLevel->onStop();
+        for (auto &level: retiredLevels) {
+            level.task->join();
         }
+        retiredLevels.clear();
     }
 
     void loadLevel(LevelID id) {
@@ -57,94 +77,216 @@ public:
             default:
             case LEVEL_MAIN_MENU:
                 nextLevel = std::make_unique<MainMenu>(eventBus,
-                                                       window,
-                                                       target,
-                                                       ren2d,
-                                                       fontDriver);
+                                                       frontend,
+                                                       fontDriver,
+                                                       sceneCache);
                 break;
             case LEVEL_ZERO:
                 nextLevel = std::make_unique<Level0>(eventBus,
-                                                     window,
-                                                     target,
-                                                     ren2d,
+                                                     frontend,
                                                      fontDriver,
                                                      physicsDriver,
-                                                     audioDevice);
+                                                     sceneCache);
                 break;
         }
     }
 
     void update(DeltaTime deltaTime) {
-        if (loading) {
-            drawLoadingScreen();
-        } else if (initLevel) {
-            initLevel = false;
-            currentLevel->awaitLoad();
-            currentLevel->onStart();
-            currentLevel->onUpdate(deltaTime);
-        } else if (nextLevel) {
+        // A level switch is only performed once the current level has finished loading.
+        if (nextLevel && state != STATE_LOADING) {
+            // Acquired before the current level releases its set so that shared assets stay resident
+            residency.acquire(nextLevel->getID(), nextLevel->getResidencySet());
             if (currentLevel) {
-                currentLevel->onStop();
-                currentLevel->unload();
+                retireLevel(std::move(currentLevel), state == STATE_RUNNING);
             }
             currentLevel = std::move(nextLevel);
             nextLevel = nullptr;
-            loading = true;
+            state = STATE_LOADING;
             loadingProgress = 0;
+            loadFinished = false;
+            loadFailed = false;
             currentLevel->startLoad(*this);
-            drawLoadingScreen();
-        } else {
-            currentLevel->awaitLoad();
-            currentLevel->onUpdate(deltaTime);
         }
+
+        switch (state) {
+            case STATE_IDLE:
+                break;
+            case STATE_LOADING:
+                if (loadFailed) {
+                    // The failed level was never started, it is dropped without onStop
+                    state = STATE_IDLE;
+                    currentLevel->awaitLoad();
+                    retireLevel(std::move(currentLevel), false);
+                    std::rethrow_exception(loadException);
+                } else if (loadFinished) {
+                    // The load task has signaled completion so joining it does not block.
+                    currentLevel->awaitLoad();
+                    {
+                        ProfileZone zone("Start level", "load");
+                        currentLevel->onStart();
+                    }
+                    addLevelCommands();
+                    state = STATE_RUNNING;
+                    currentLevel->onUpdate(deltaTime);
+                } else if (!frontend.isHeadless()) {
+                    drawLoadingScreen();
+                }
+                break;
+            case STATE_RUNNING:
+                currentLevel->onUpdate(deltaTime);
+                break;
+        }
+
+        destroyRetiredLevels();
+        residency.update();
+
+        // The scene templates of the released levels keep their assets loaded, evicted assets are only freed without them
+        if (residency.getEvictionCount() != evictionCount) {
+            evictionCount = residency.getEvictionCount();
+            for (auto &pair: sceneCache.getEntries()) {
+                if (!currentLevel || pair.first != currentLevel->getID())
+                    sceneCache.evict(pair.first);
+            }
+        }
+    }
+
+    /**
+     * Wait for the simulation of the running level, see Level::awaitSimulation.
+     */
+    void awaitSimulation() {
+        if (state == STATE_RUNNING)
+            currentLevel->awaitSimulation();
+    }
+
+    State getState() const {
+        return state;
+    }
+
+    ResourceResidency &getResidency() {
+        return residency;
     }
 
 private:
+    static const size_t RESIDENCY_BUDGET = 256 * 1024 * 1024;
+
+    struct RetiredLevel {
+        std::unique_ptr<Level> level;
+        std::shared_ptr<Task> task;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+
+    /**
+     * Stop the level on the main thread and release its resources on a worker thread.
+     * The level object itself is destroyed on the main thread once the worker has finished
+     * because its systems may own render resources.
+     *
+     * @param level
+     * @param started Whether onStart has been called on the level, onStop is only called if it has
+     */
+    void retireLevel(std::unique_ptr<Level> level, bool started) {
+        if (started) {
+            removeLevelCommands();
+            level->onStop();
+        }
+
+        // When reloading the same level the set has already been replaced by the one of the new instance
+        if (!nextLevel || nextLevel->getID() != level->getID())
+            residency.release(level->getID());
+
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        auto *ptr = level.get();
+        auto task = ThreadPool::getPool().addTask([ptr, finished]() {
+            ProfileZone zone("Unload level", "load");
+            ptr->unload();
+            *finished = true;
+        });
+
+        retiredLevels.emplace_back(RetiredLevel{std::move(level), task, finished});
+    }
+
+    void destroyRetiredLevels() {
+        for (auto it = retiredLevels.begin(); it != retiredLevels.end();) {
+            if (*it->finished) {
+                it->task->join();
+                it = retiredLevels.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    // Invoked from the thread pool
     void onLoadProgress(LevelID level, float progress) override {
         loadingProgress = progress;
     }
 
     void onLoadFinish(LevelID level) override {
-        initLevel = true;
-        loading = false;
+        loadFinished = true;
     }
 
     void onLoadError(LevelID level, std::exception_ptr exception) override {
-        loading = false;
-        loadException = exception;
+        loadException = std::move(exception);
+        loadFailed = true;
     }
 
 private:
+    void addLevelCommands() {
+        std::set<std::string> existing;
+        for (auto &pair: commands.getCommands()) {
+            existing.insert(pair.first);
+        }
+        currentLevel->registerCommands(commands);
+        for (auto &pair: commands.getCommands()) {
+            if (existing.find(pair.first) == existing.end())
+                levelCommands.emplace_back(pair.first);
+        }
+    }
+
+    void removeLevelCommands() {
+        for (auto &name: levelCommands) {
+            commands.remove(name);
+        }
+        levelCommands.clear();
+    }
+
     void drawLoadingScreen() {
-        auto targetSize = target.getDescription().size.convert<float>();
+        auto &ren2d = *frontend.ren2d;
+        auto targetSize = frontend.getViewportSize().convert<float>();
         auto size = targetSize;
         size.x /= 3;
         size.y /= 10;
-        ren2d.renderBegin(target, clearColor);
+        ren2d.renderBegin(*frontend.target, clearColor);
         ren2d.draw(Rectf(targetSize / 2 - size / 2, size), barBgColor, true);
-        ren2d.draw(Rectf(targetSize / 2 - size / 2, {size.x * loadingProgress, size.y}), barColor, true);
+        ren2d.draw(Rectf(targetSize / 2 - size / 2, {size.x * loadingProgress.load(), size.y}), barColor, true);
         ren2d.renderPresent();
     }
 
-    RenderTarget &target;
-    Renderer2D &ren2d;
-    Window &window;
+    Frontend &frontend;
     FontDriver &fontDriver;
     PhysicsDriver &physicsDriver;
-    AudioDevice &audioDevice;
+    SceneTemplateCache &sceneCache;
     std::shared_ptr<EventBus> eventBus;
+    CommandRegistry &commands;
+    std::vector<std::string> levelCommands; // The commands registered by the running level
+
+    ResourceResidency residency{RESIDENCY_BUDGET};
+    size_t evictionCount = 0;
 
     std::unique_ptr<Level> currentLevel;
     std::unique_ptr<Level> nextLevel;
 
-    bool initLevel = false;
-    std::exception_ptr loadException;
-    bool loading = false;
+    std::list<RetiredLevel> retiredLevels;
+
+    State state = STATE_IDLE;
+
+    std::atomic<bool> loadFinished = false;
+    std::atomic<bool> loadFailed = false;
+    std::exception_ptr loadException; // Written before loadFailed is set
+    std::atomic<float> loadingProgress = 0;
 
     ColorRGBA barBgColor = ColorRGBA::white(0.5);
     ColorRGBA barColor = ColorRGBA::white();
     ColorRGBA clearColor = ColorRGBA::black();
-    float loadingProgress = 0;
 };
 
 #endif //FOXTROT_LEVELLOADER_HPP
@@ -23,6 +23,16 @@
 #include <utility>
 
 #include "level.hpp"
+#include "scenetemplatecache.hpp"
+#include "frontend.hpp"
+
+#include "resource/assets.hpp"
+
+#include "cvars.hpp"
+
+#include "simulation/fixedstepruntime.hpp"
+
+#include "scheduler/systemscheduler.hpp"
 
 #include "systems/inputsystem.hpp"
 #include "systems/camerasystem.hpp"
@@ -33,52 +43,117 @@
 #include "systems/playercontrollersystem.hpp"
 #include "systems/gameguisystem.hpp"
 #include "systems/cursorsystem.hpp"
+#include "systems/chunkstreamingsystem.hpp"
+
+#include "headless/nullrendersystem.hpp"
+#include "headless/nullaudiosystem.hpp"
 
 class Level0 : public Level, public EventListener {
 public:
     Level0(std::shared_ptr<EventBus> eventBus,
-           Window &window,
-           RenderTarget &target,
-           Renderer2D &ren2d,
+           Frontend &frontend,
            FontDriver &fontDriver,
            PhysicsDriver &physicsDriver,
-           AudioDevice &audioDevice)
+           SceneTemplateCache &sceneCache)
             : eventBus(std::move(eventBus)),
-              target(target),
+              sceneCache(sceneCache),
               physicsDriver(physicsDriver),
               world(physicsDriver.createWorld()),
-              guiEventSystem(std::make_shared<GuiEventSystem>(window)),
-              inputSystem(std::make_shared<InputSystem>(window.getInput())),
               characterControllerSystem(std::make_shared<CharacterControllerSystem>()),
-              playerControllerSystem(std::make_shared<PlayerControllerSystem>()),
-              canvasRenderSystem(std::make_shared<CanvasRenderSystem>(ren2d,
-                                                                      target,
-                                                                      fontDriver)),
-              bulletSystem(std::make_shared<BulletSystem>()),
-              gameGuiSystem(std::make_shared<GameGuiSystem>(window.getInput())),
-              physicsSystem(std::make_shared<PhysicsSystem>(*world, 30, 1.0f / 300)),
-              cameraSystem(std::make_shared<CameraSystem>(target, Vec2f(-10100, -10100), Vec2f(10100, 100))),
-              cursorSystem(std::make_shared<CursorSystem>(window.getInput())),
-              audioSystem(std::make_shared<AudioSystem>(audioDevice, ResourceRegistry::getDefaultRegistry())),
-              ren2d(ren2d) {
-        world->setGravity(Vec3f(0, -20, 0));
+              playerControllerSystem(std::make_shared<PlayerControllerSystem>(simulationScheduler->getCommands())),
+              bulletSystem(std::make_shared<BulletSystem>(simulationScheduler->getCommands())),
+              physicsSystem(std::make_shared<PhysicsSystem>(*world,
+                                                            CVars::physicsSubsteps.get(),
+                                                            CVars::physicsTimestep.get())),
+              cameraSystem(std::make_shared<CameraSystem>(frontend, Vec2f(-10100, -10100), Vec2f(10100, 100))),
+              chunkStreamingSystem(std::make_shared<ChunkStreamingSystem>(frontend,
+                                                                          simulationScheduler->getCommands())) {
+        if (frontend.isHeadless()) {
+            nullRenderSystem = std::make_shared<NullRenderSystem>(frontend.headlessStats);
+            nullAudioSystem = std::make_shared<NullAudioSystem>(frontend.headlessStats);
+        } else {
+            auto &window = *frontend.window;
+            guiEventSystem = std::make_shared<GuiEventSystem>(window);
+            inputSystem = std::make_shared<InputSystem>(window.getInput());
+            gameGuiSystem = std::make_shared<GameGuiSystem>(window.getInput());
+            cursorSystem = std::make_shared<CursorSystem>(window.getInput());
+            canvasRenderSystem = std::make_shared<CanvasRenderSystem>(*frontend.ren2d,
+                                                                      *frontend.target,
+                                                                      fontDriver);
+            audioSystem = std::make_shared<AudioSystem>(*frontend.audioDevice,
+                                                        ResourceRegistry::getDefaultRegistry());
+        }
+        world->setGravity(Vec3f(0, CVars::gravity.get(), 0));
+        gravityModification = CVars::gravity.getModificationCount();
+
+        addSimulationSystems(*simulationScheduler,
+                             physicsSystem,
+                             characterControllerSystem,
+                             playerControllerSystem,
+                             bulletSystem,
+                             chunkStreamingSystem);
+        addFrameSystems(*frameScheduler,
+                        inputSystem,
+                        cameraSystem,
+                        gameGuiSystem,
+                        cursorSystem,
+                        spriteAnimationSystem);
+        simulationScheduler->setVerify(CVars::schedulerVerify.get());
+        frameScheduler->setVerify(CVars::schedulerVerify.get());
+        schedulerVerifyModification = CVars::schedulerVerify.getModificationCount();
     }
 
     ~Level0() {}
 
+    /**
+     * Build the simulation and frame graphs without creating the systems or the level.
+     * Throws if two systems access the same component without an ordering between them,
+     * which would otherwise only be detected when the level is loaded.
+     */
+    static void checkSimulationGraph() {
+        SystemScheduler simulation;
+        addSimulationSystems(simulation, nullptr, nullptr, nullptr, nullptr, nullptr);
+        SystemScheduler frame;
+        addFrameSystems(frame, nullptr, nullptr, nullptr, nullptr, nullptr);
+    }
+
     LevelID getID() override {
         return LEVEL_ZERO;
     }
 
+    ResidencySet getResidencySet() override {
+        // The assets of the scene are listed by the asset manifest,
+        // the others are referenced from code by the player, the weapons, the bullets and the gui systems
+        return ResidencySet()
+                .addReferences(ASSET_SCENES_LEVEL_0_JSON_REFERENCES)
+                .add<SpriteAnimation>({ASSET_ANIMATIONS_BULLET_SMALL_JSON,
+                                       ASSET_ANIMATIONS_DANTE_DEATH_JSON,
+                                       ASSET_ANIMATIONS_DANTE_FALL_JSON,
+                                       ASSET_ANIMATIONS_MUZZLE_A_JSON})
+                .add<Sprite>({ASSET_SPRITES_TOOLBAR_JSON,
+                              ASSET_SPRITES_CELLTILE_JSON_IDLE,
+                              ASSET_SPRITES_CELLTILE_JSON_HOVER,
+                              ASSET_SPRITES_CELLTILE_JSON_PRESS,
+                              ASSET_SPRITES_CROSSHAIR_JSON_TARGET,
+                              ASSET_SPRITES_REVOLVER_JSON_0,
+                              ASSET_SPRITES_REVOLVER_JSON_2,
+                              ASSET_SPRITES_GATLING_JSON_0,
+                              ASSET_SPRITES_GATLING_JSON_1})
+                .add<Audio>(ASSET_SOUND_EFFECTS_GUNSHOT_0_WAV);
+    }
+
     void startLoad(LoadListener &listener) override {
         loadTask = ThreadPool::getPool().addTask([this, &listener]() {
-            auto handle = ResourceHandle<EntityScene>(Uri("scenes/level_0.json"));
-            auto s = handle.get();
-            scene = std::make_shared<EntityScene>(s);
-            listener.onLoadProgress(getID(), 0.5);
-            ResourceRegistry::getDefaultRegistry().awaitImports();
-            listener.onLoadProgress(getID(), 1);
-            listener.onLoadFinish(getID());
+            ProfileZone zone("Load Level0", "load");
+            try {
+                scene = sceneCache.instantiate(getID(), Assets::uri(ASSET_SCENES_LEVEL_0_JSON));
+                listener.onLoadProgress(getID(), 0.5);
+                ResourceRegistry::getDefaultRegistry().awaitImports();
+                listener.onLoadProgress(getID(), 1);
+                listener.onLoadFinish(getID());
+            } catch (...) {
+                listener.onLoadError(getID(), std::current_exception());
+            }
         });
     }
 
@@ -87,70 +162,151 @@ public:
     }
 
     void unload() override {
-        Level::unload();
+        scene = {};
     }
 
     void onStart() override {
         eventBus->addListener(*this);
-        ecs = SystemRuntime({SystemPipeline(xng::SystemPipeline::TICK_FRAME,
-                                            {guiEventSystem,
-
-                                             physicsSystem,
-
-                                             daytimeSystem,
-                                             inputSystem,
-                                             characterControllerSystem,
-                                             playerControllerSystem,
-                                             bulletSystem,
-
-                                             cameraSystem,
-
-                                             gameGuiSystem,
-                                             cursorSystem,
-
-                                             spriteAnimationSystem,
-                                             canvasRenderSystem,
-
-                                             audioSystem})},
-                            scene,
-                            eventBus);
-        ecs.start();
+        // Gameplay runs at the fixed simulation rate on the thread pool,
+        // input and the systems preparing the scene for presentation run once per frame at the sync point
+        // and only the drawing runs concurrently to the simulation.
+        // The gui events invoke listeners which load levels and the audio device is not thread safe,
+        // so these systems run on the calling thread around the frame scheduler.
+        ecs = std::make_unique<FixedStepRuntime>(createPipeline({guiEventSystem,
+                                                                 frameScheduler,
+                                                                 audioSystem,
+                                                                 nullAudioSystem}),
+                                                 createPipeline({simulationScheduler}),
+                                                 createPipeline({canvasRenderSystem,
+                                                                 nullRenderSystem}),
+                                                 scene,
+                                                 eventBus,
+                                                 1.0f / static_cast<float>(CVars::simRate.get()),
+                                                 CVars::simMaxSteps.get());
+        ecs->start();
     }
 
     void onUpdate(DeltaTime deltaTime) override {
-        ecs.update(deltaTime);
+        if (gravityModification != CVars::gravity.getModificationCount()) {
+            gravityModification = CVars::gravity.getModificationCount();
+            ecs->awaitSimulation();
+            world->setGravity(Vec3f(0, CVars::gravity.get(), 0));
+        }
+        if (schedulerVerifyModification != CVars::schedulerVerify.getModificationCount()) {
+            schedulerVerifyModification = CVars::schedulerVerify.getModificationCount();
+            ecs->awaitSimulation();
+            simulationScheduler->setVerify(CVars::schedulerVerify.get());
+            frameScheduler->setVerify(CVars::schedulerVerify.get());
+        }
+        ecs->update(deltaTime);
+    }
+
+    void awaitSimulation() override {
+        ecs->awaitSimulation();
     }
 
     void onStop() override {
-        ecs = SystemRuntime();
-        scene = {};
+        ecs->stop();
+        ecs = nullptr;
         eventBus->removeListener(*this);
     }
 
+    void registerCommands(CommandRegistry &commands) override {
+        commands.add("violations", "Print the undeclared component accesses of the scheduled systems", {},
+                     [this](ConsoleOutput &output) {
+                         // The violations are recorded by the simulation task
+                         ecs->awaitSimulation();
+                         if (!simulationScheduler->getVerify())
+                             output.print("Verification is disabled, set sched_verify to record violations");
+                         for (auto &violation: simulationScheduler->getViolations()) {
+                             output.print(violation);
+                         }
+                         for (auto &violation: frameScheduler->getViolations()) {
+                             output.print(violation);
+                         }
+                     });
+        commands.add("schedule", "Print the pairs of scheduled systems which may run concurrently", {},
+                     [this](ConsoleOutput &output) {
+                         if (simulationScheduler->getVerify())
+                             output.print("Verification is enabled, the systems run sequentially");
+                         for (auto &pair: simulationScheduler->getConcurrentPairs()) {
+                             output.print("simulation: " + pair.first + " | " + pair.second);
+                         }
+                         for (auto &pair: frameScheduler->getConcurrentPairs()) {
+                             output.print("frame: " + pair.first + " | " + pair.second);
+                         }
+                     });
+    }
+
     void onEvent(const Event &event) override {
         if (event.getEventType() == typeid(KeyboardEvent)) {
             auto &kbev = event.as<KeyboardEvent>();
             if (kbev.type == xng::KeyboardEvent::KEYBOARD_KEY_DOWN
                 && kbev.key == xng::KEY_F1) {
                 drawDebug = !drawDebug;
-                canvasRenderSystem->setDrawDebugGeometry(drawDebug);
+                if (canvasRenderSystem)
+                    canvasRenderSystem->setDrawDebugGeometry(drawDebug);
             }
         }
     }
 
 private:
-    RenderTarget &target;
-    Renderer2D &ren2d;
+    static void addSimulationSystems(SystemScheduler &scheduler,
+                                     std::shared_ptr<System> physics,
+                                     std::shared_ptr<System> characterController,
+                                     std::shared_ptr<System> playerController,
+                                     std::shared_ptr<System> bullet,
+                                     std::shared_ptr<System> chunkStreaming) {
+        scheduler.add("physics",
+                      std::move(physics),
+                      SystemAccess().writes<TransformComponent, RigidBodyComponent, ContactEvent>());
+        scheduler.add("charactercontroller",
+                      std::move(characterController),
+                      CharacterControllerSystem::getAccess(),
+                      {"physics"});
+        scheduler.add("playercontroller",
+                      std::move(playerController),
+                      PlayerControllerSystem::getAccess(),
+                      {"charactercontroller"});
+        // The bullets and the streamed chunks do not share any component and run concurrently
+        scheduler.add("bullet", std::move(bullet), BulletSystem::getAccess(), {"playercontroller"});
+        scheduler.add("chunkstreaming",
+                      std::move(chunkStreaming),
+                      ChunkStreamingSystem::getAccess(),
+                      {"playercontroller"});
+    }
+
+    static void addFrameSystems(SystemScheduler &scheduler,
+                                std::shared_ptr<System> input,
+                                std::shared_ptr<System> camera,
+                                std::shared_ptr<System> gameGui,
+                                std::shared_ptr<System> cursor,
+                                std::shared_ptr<System> spriteAnimation) {
+        scheduler.add("input", std::move(input), InputSystem::getAccess());
+        // The camera follows the simulated characters and runs concurrently with the input and gui systems
+        scheduler.add("camera", std::move(camera), CameraSystem::getAccess());
+        scheduler.add("gamegui", std::move(gameGui), GameGuiSystem::getAccess(), {"input"});
+        scheduler.add("cursor", std::move(cursor), CursorSystem::getAccess(), {"gamegui"});
+        scheduler.add("spriteanimation",
+                      std::move(spriteAnimation),
+                      SystemAccess().writes<SpriteAnimationComponent, SpriteComponent>());
+    }
 
     PhysicsDriver &physicsDriver;
 
     std::shared_ptr<EventBus> eventBus;
 
+    SceneTemplateCache &sceneCache;
+
     std::shared_ptr<EntityScene> scene;
 
     std::unique_ptr<World> world;
 
-    SystemRuntime ecs;
+    std::unique_ptr<FixedStepRuntime> ecs;
+
+    // Declared before the systems which are constructed with the command buffer of the simulation scheduler
+    std::shared_ptr<SystemScheduler> simulationScheduler = std::make_shared<SystemScheduler>();
+    std::shared_ptr<SystemScheduler> frameScheduler = std::make_shared<SystemScheduler>();
 
     std::shared_ptr<CanvasRenderSystem> canvasRenderSystem;
     std::shared_ptr<SpriteAnimationSystem> spriteAnimationSystem;
@@ -158,7 +314,7 @@ private:
     std::shared_ptr<InputSystem> inputSystem;
 
     std::shared_ptr<GuiEventSystem> guiEventSystem;
-    std::shared_ptr<TimeSystem> daytimeSystem;
+    std::shared_ptr<TimeSystem> daytimeSystem; // Not created, the day and night cycle is disabled
     std::shared_ptr<CharacterControllerSystem> characterControllerSystem;
     std::shared_ptr<PlayerControllerSystem> playerControllerSystem;
     std::shared_ptr<GameGuiSystem> gameGuiSystem;
@@ -166,10 +322,17 @@ private:
 
     std::shared_ptr<PhysicsSystem> physicsSystem;
     std::shared_ptr<CameraSystem> cameraSystem;
+    std::shared_ptr<ChunkStreamingSystem> chunkStreamingSystem;
     std::shared_ptr<BulletSystem> bulletSystem;
 
+    std::shared_ptr<NullRenderSystem> nullRenderSystem;
+    std::shared_ptr<NullAudioSystem> nullAudioSystem;
+
     bool drawDebug = false;
 
+    size_t gravityModification = 0; // The modification count of the gravity cvar applied to the world
+    size_t schedulerVerifyModification = 0;
+
     std::shared_ptr<Task> loadTask;
 };
 
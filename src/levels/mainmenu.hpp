@@ -25,26 +25,36 @@
 #include "xng/xng.hpp"
 
 #include "level.hpp"
+#include "scenetemplatecache.hpp"
+#include "frontend.hpp"
+
+#include "resource/assets.hpp"
 #include "events/loadlevelevent.hpp"
 
 #include "systems/menuguisystem.hpp"
 
+#include "headless/nullrendersystem.hpp"
+
 using namespace xng;
 
 class MainMenu : public Level, public EventListener {
 public:
     MainMenu(std::shared_ptr<EventBus> eventBus,
-             Window &window,
-             RenderTarget &target,
-             Renderer2D &ren2d,
-             FontDriver &fontDriver)
+             Frontend &frontend,
+             FontDriver &fontDriver,
+             SceneTemplateCache &sceneCache)
             : eventBus(std::move(eventBus)),
-              guiEventSystem(std::make_shared<GuiEventSystem>(window)),
-              menuGuiSystem(std::make_shared<MenuGuiSystem>(window.getInput())),
-              spriteAnimationSystem(std::make_shared<SpriteAnimationSystem>()),
-              canvasRenderSystem(std::make_shared<CanvasRenderSystem>(ren2d,
-                                                                      target,
-                                                                      fontDriver)) {
+              sceneCache(sceneCache),
+              spriteAnimationSystem(std::make_shared<SpriteAnimationSystem>()) {
+        if (frontend.isHeadless()) {
+            nullRenderSystem = std::make_shared<NullRenderSystem>(frontend.headlessStats);
+        } else {
+            guiEventSystem = std::make_shared<GuiEventSystem>(*frontend.window);
+            menuGuiSystem = std::make_shared<MenuGuiSystem>(frontend.window->getInput());
+            canvasRenderSystem = std::make_shared<CanvasRenderSystem>(*frontend.ren2d,
+                                                                      *frontend.target,
+                                                                      fontDriver);
+        }
     }
 
     ~MainMenu() {
@@ -55,15 +65,18 @@ public:
         return LEVEL_MAIN_MENU;
     }
 
+    ResidencySet getResidencySet() override {
+        return ResidencySet().addReferences(ASSET_SCENES_MENU_JSON_REFERENCES);
+    }
+
     void onStart() override {
-        auto handle = ResourceHandle<EntityScene>(Uri("scenes/menu.json"));
         eventBus->addListener(*this);
-        scene = std::make_shared<EntityScene>(handle.get());
-        ecs = SystemRuntime({SystemPipeline(xng::SystemPipeline::TICK_FRAME,
-                                            {guiEventSystem,
+        scene = sceneCache.instantiate(getID(), Assets::uri(ASSET_SCENES_MENU_JSON));
+        ecs = SystemRuntime({createPipeline({guiEventSystem,
                                              menuGuiSystem,
                                              spriteAnimationSystem,
-                                             canvasRenderSystem})},
+                                             canvasRenderSystem,
+                                             nullRenderSystem})},
                             scene,
                             eventBus);
         ecs.start();
@@ -73,6 +86,9 @@ public:
         eventBus->removeListener(*this);
         ecs.stop();
         ecs = SystemRuntime();
+    }
+
+    void unload() override {
         scene = {};
     }
 
@@ -86,7 +102,8 @@ public:
             if (kbev.type == xng::KeyboardEvent::KEYBOARD_KEY_DOWN
                 && kbev.key == xng::KEY_F1) {
                 drawDebug = !drawDebug;
-                canvasRenderSystem->setDrawDebugGeometry(drawDebug);
+                if (canvasRenderSystem)
+                    canvasRenderSystem->setDrawDebugGeometry(drawDebug);
             }
         }
     }
@@ -94,10 +111,13 @@ public:
 private:
     std::shared_ptr<EventBus> eventBus;
 
+    SceneTemplateCache &sceneCache;
+
     std::shared_ptr<GuiEventSystem> guiEventSystem;
     std::shared_ptr<CanvasRenderSystem> canvasRenderSystem;
     std::shared_ptr<SpriteAnimationSystem> spriteAnimationSystem;
     std::shared_ptr<MenuGuiSystem> menuGuiSystem;
+    std::shared_ptr<NullRenderSystem> nullRenderSystem;
 
     std::shared_ptr<EntityScene> scene;
 
@@ -35,35 +35,35 @@ public:
     };
 
     Player()
-            : idleAnimationAim(Uri("animations/dante_idle.json")),
-              walkAnimationAim(Uri("animations/dante_run.json")),
-              runAnimationAim(Uri("animations/dante_run.json")),
-              idleAnimationHip(Uri("animations/dante_idle_low.json")),
-              runAnimationHip(Uri("animations/dante_run_low.json")),
-              walkAnimationHip(Uri("animations/dante_run_low.json")),
-              fallAnimation(Uri("animations/dante_fall.json")),
-              deathAnimation(Uri("animations/dante_death.json")),
+            : idleAnimationAim(Assets::uri(ASSET_ANIMATIONS_DANTE_IDLE_JSON)),
+              walkAnimationAim(Assets::uri(ASSET_ANIMATIONS_DANTE_RUN_JSON)),
+              runAnimationAim(Assets::uri(ASSET_ANIMATIONS_DANTE_RUN_JSON)),
+              idleAnimationHip(Assets::uri(ASSET_ANIMATIONS_DANTE_IDLE_LOW_JSON)),
+              runAnimationHip(Assets::uri(ASSET_ANIMATIONS_DANTE_RUN_LOW_JSON)),
+              walkAnimationHip(Assets::uri(ASSET_ANIMATIONS_DANTE_RUN_LOW_JSON)),
+              fallAnimation(Assets::uri(ASSET_ANIMATIONS_DANTE_FALL_JSON)),
+              deathAnimation(Assets::uri(ASSET_ANIMATIONS_DANTE_DEATH_JSON)),
               pistol(),
-              gatling(ResourceHandle<Sprite>(Uri("sprites/gatling.json/0")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/2")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/4")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/6")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/8")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/10")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/12")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/14")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/16")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/18")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/1")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/3")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/5")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/7")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/9")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/11")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/13")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/15")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/17")),
-                      ResourceHandle<Sprite>(Uri("sprites/gatling.json/19"))) {}
+              gatling(ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_0)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_2)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_4)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_6)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_8)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_10)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_12)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_14)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_16)),
+                      ResourceHandle<Sprite>(),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_1)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_3)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_5)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_7)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_9)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_11)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_13)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_15)),
+                      ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_GATLING_JSON_17)),
+                      ResourceHandle<Sprite>()) {}
 
     Weapon &getWeapon() {
         switch (equippedWeapon) {
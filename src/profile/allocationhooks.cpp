@@ -0,0 +1,76 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Replaces the global new and delete operators to count the allocations, see AllocationTracker.
+// The aligned overloads are not replaced and are not counted.
+
+#ifdef FOXTROT_TRACK_ALLOCATIONS
+
+#include <new>
+#include <cstdlib>
+
+#include "profile/allocationtracker.hpp"
+
+void *operator new(std::size_t size) {
+    AllocationTracker::onAllocate(size);
+    if (auto *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    AllocationTracker::onAllocate(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept {
+    if (ptr != nullptr)
+        AllocationTracker::onFree();
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    operator delete(ptr);
+}
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_ALLOCATIONTRACKER_HPP
+#define FOXTROT_ALLOCATIONTRACKER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+/**
+ * Counts the global allocations per frame and attributes them to the running system.
+ *
+ * The global new and delete operators are only hooked when built with TRACK_ALLOCATIONS (FOXTROT_TRACK_ALLOCATIONS),
+ * tracking then still has to be enabled at runtime.
+ *
+ * In assert mode an allocation by a system aborts the process at the end of the frame after printing the system,
+ * this is used to verify an allocation free steady state in replayed gameplay.
+ */
+class AllocationTracker {
+public:
+    struct Counters {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Scope {
+        std::string name;
+        std::atomic<uint64_t> frameAllocations = 0;
+        std::atomic<uint64_t> frameBytes = 0;
+        Counters lastFrame;
+        Counters total;
+    };
+
+    static AllocationTracker &getDefaultTracker() {
+        static AllocationTracker tracker;
+        return tracker;
+    }
+
+    static constexpr bool isAvailable() {
+#ifdef FOXTROT_TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Called by the global new operators, must not allocate.
+     */
+    static void onAllocate(size_t size) {
+        if (!isEnabled())
+            return;
+        frameAllocations.fetch_add(1, std::memory_order_relaxed);
+        frameBytes.fetch_add(size, std::memory_order_relaxed);
+        if (currentScope != nullptr) {
+            currentScope->frameAllocations.fetch_add(1, std::memory_order_relaxed);
+            currentScope->frameBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Called by the global delete operators, must not allocate.
+     */
+    static void onFree() {
+        if (!isEnabled())
+            return;
+        frameFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool value) {
+        enabled = value && isAvailable();
+    }
+
+    /**
+     * @param value If true allocations by systems abort the process at the end of the frame
+     */
+    void setAssert(bool value) {
+        asserting = value;
+    }
+
+    bool getAssert() const {
+        return asserting;
+    }
+
+    /**
+     * Get the counters of the named scope, creating them if necessary.
+     * The returned scope stays valid for the lifetime of the tracker.
+     */
+    Scope &getScope(std::string_view name) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = scopes.find(name);
+        if (it == scopes.end()) {
+            auto scope = std::make_unique<Scope>();
+            scope->name = name;
+            it = scopes.emplace(scope->name, std::move(scope)).first;
+        }
+        return *it->second;
+    }
+
+    /**
+     * Move the counts of the frame into the last frame counters, called once per frame on the main thread.
+     */
+    void endFrame() {
+        if (!isEnabled())
+            return;
+
+        lastFrame.allocations = frameAllocations.exchange(0, std::memory_order_relaxed);
+        lastFrame.bytes = frameBytes.exchange(0, std::memory_order_relaxed);
+        lastFrameFrees = frameFrees.exchange(0, std::memory_order_relaxed);
+        total.allocations += lastFrame.allocations;
+        total.bytes += lastFrame.bytes;
+        frames++;
+
+        std::lock_guard<std::mutex> guard(mutex);
+        bool violated = false;
+        for (auto &pair: scopes) {
+            auto &scope = *pair.second;
+            scope.lastFrame.allocations = scope.frameAllocations.exchange(0, std::memory_order_relaxed);
+            scope.lastFrame.bytes = scope.frameBytes.exchange(0, std::memory_order_relaxed);
+            scope.total.allocations += scope.lastFrame.allocations;
+            scope.total.bytes += scope.lastFrame.bytes;
+            if (asserting && scope.lastFrame.allocations > 0) {
+                std::cerr << "Allocation in steady state: " << scope.name << " allocated "
+                          << scope.lastFrame.bytes << " bytes in "
+                          << scope.lastFrame.allocations << " allocations" << std::endl;
+                violated = true;
+            }
+        }
+        if (violated) {
+            std::abort();
+        }
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> guard(mutex);
+        lastFrame = {};
+        lastFrameFrees = 0;
+        total = {};
+        frames = 0;
+        for (auto &pair: scopes) {
+            pair.second->lastFrame = {};
+            pair.second->total = {};
+        }
+    }
+
+    const Counters &getLastFrame() const {
+        return lastFrame;
+    }
+
+    uint64_t getLastFrameFrees() const {
+        return lastFrameFrees;
+    }
+
+    const Counters &getTotal() const {
+        return total;
+    }
+
+    uint64_t getFrames() const {
+        return frames;
+    }
+
+    /**
+     * @return The scopes sorted by their allocations in the last frame, most allocations first
+     */
+    std::vector<const Scope *> getScopes() {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::vector<const Scope *> ret;
+        for (auto &pair: scopes) {
+            ret.emplace_back(pair.second.get());
+        }
+        std::sort(ret.begin(), ret.end(), [](const Scope *a, const Scope *b) {
+            return a->lastFrame.allocations > b->lastFrame.allocations;
+        });
+        return ret;
+    }
+
+private:
+    friend class AllocationScope;
+
+    AllocationTracker() = default;
+
+    static inline std::atomic<bool> enabled = false;
+    static inline std::atomic<uint64_t> frameAllocations = 0;
+    static inline std::atomic<uint64_t> frameBytes = 0;
+    static inline std::atomic<uint64_t> frameFrees = 0;
+    static inline thread_local Scope *currentScope = nullptr;
+
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Scope>, std::less<>> scopes;
+
+    bool asserting = false;
+
+    Counters lastFrame;
+    uint64_t lastFrameFrees = 0;
+    Counters total;
+    uint64_t frames = 0;
+};
+
+/**
+ * Attributes the allocations of the calling thread to the named scope while the object lives.
+ *
+ * Does nothing when allocation tracking is disabled.
+ */
+class AllocationScope {
+public:
+    explicit AllocationScope(std::string_view name) {
+        if (AllocationTracker::isEnabled()) {
+            active = true;
+            previous = AllocationTracker::currentScope;
+            AllocationTracker::currentScope = &AllocationTracker::getDefaultTracker().getScope(name);
+        }
+    }
+
+    AllocationScope(const AllocationScope &other) = delete;
+
+    AllocationScope &operator=(const AllocationScope &other) = delete;
+
+    ~AllocationScope() {
+        if (active)
+            AllocationTracker::currentScope = previous;
+    }
+
+private:
+    bool active = false;
+    AllocationTracker::Scope *previous = nullptr;
+};
+
+#endif //FOXTROT_ALLOCATIONTRACKER_HPP
@@ -0,0 +1,81 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_PROFILEDSYSTEM_HPP
+#define FOXTROT_PROFILEDSYSTEM_HPP
+
+#include <typeinfo>
+#include <cstdlib>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include "xng/xng.hpp"
+
+#include "profile/profiler.hpp"
+#include "profile/allocationtracker.hpp"
+
+using namespace xng;
+
+/**
+ * Forwards to a system and records its start, stop and update as profiler zones named after the system type.
+ * The allocations of the update are attributed to the system type.
+ */
+class ProfiledSystem : public System {
+public:
+    explicit ProfiledSystem(std::shared_ptr<System> system)
+            : system(std::move(system)),
+              name(getTypeName(typeid(*this->system))) {}
+
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        ProfileZone zone(name, "start");
+        system->start(scene, eventBus);
+    }
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        ProfileZone zone(name, "stop");
+        system->stop(scene, eventBus);
+    }
+
+    void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        ProfileZone zone(name, "system");
+        AllocationScope allocationScope(name);
+        system->update(deltaTime, scene, eventBus);
+    }
+
+private:
+    static std::string getTypeName(const std::type_info &type) {
+#ifdef __GNUG__
+        int status = 0;
+        auto *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+        if (status == 0 && demangled != nullptr) {
+            std::string ret(demangled);
+            std::free(demangled);
+            return ret;
+        }
+#endif
+        return type.name();
+    }
+
+    std::shared_ptr<System> system;
+    std::string name;
+};
+
+#endif //FOXTROT_PROFILEDSYSTEM_HPP
@@ -0,0 +1,203 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_PROFILER_HPP
+#define FOXTROT_PROFILER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+
+/**
+ * Records timed zones of all threads and writes them as Chrome trace event JSON,
+ * which can be opened in chrome://tracing or Perfetto.
+ *
+ * Each thread records into its own buffer, when profiling is off a zone only costs an atomic load.
+ */
+class Profiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static Profiler &getDefaultProfiler() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Discard the recorded zones and start recording.
+     */
+    void start() {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &buffer: buffers) {
+            std::lock_guard<std::mutex> bufferGuard(buffer->mutex);
+            buffer->events.clear();
+        }
+        // Published before enabling, zones which started in a previous recording may still read it concurrently
+        origin.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+        enabled = true;
+    }
+
+    /**
+     * Stop recording and write the recorded zones to the file.
+     *
+     * @return The number of written zones
+     */
+    size_t stop(const std::filesystem::path &file) {
+        enabled = false;
+
+        std::ofstream stream(file);
+        stream << "{\"traceEvents\":[\n";
+        size_t count = 0;
+        bool first = true;
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &buffer: buffers) {
+            std::lock_guard<std::mutex> bufferGuard(buffer->mutex);
+            if (!first)
+                stream << ",\n";
+            first = false;
+            stream << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->id
+                   << R"(,"args":{"name":")" << escape(buffer->name) << "\"}}";
+            for (auto &event: buffer->events) {
+                stream << ",\n"
+                       << R"({"name":")" << escape(event.name)
+                       << R"(","cat":")" << event.category
+                       << R"(","ph":"X","ts":)" << event.start
+                       << R"(,"dur":)" << event.duration
+                       << R"(,"pid":1,"tid":)" << buffer->id << "}";
+                count++;
+            }
+            buffer->events.clear();
+        }
+        stream << "\n]}\n";
+        return count;
+    }
+
+    /**
+     * Record a zone of the calling thread, zones which started before the recording started are dropped.
+     */
+    void record(std::string_view name, const char *category, Clock::time_point start, Clock::time_point end) {
+        auto origin = Clock::time_point(Clock::duration(this->origin.load(std::memory_order_acquire)));
+        if (start < origin)
+            return;
+        auto &buffer = getThreadBuffer();
+        std::lock_guard<std::mutex> guard(buffer.mutex);
+        buffer.events.emplace_back(Event{
+                std::string(name),
+                category,
+                std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count(),
+                std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()});
+    }
+
+    /**
+     * Set the name of the calling thread shown in the trace.
+     */
+    void setThreadName(const std::string &name) {
+        auto &buffer = getThreadBuffer();
+        std::lock_guard<std::mutex> guard(buffer.mutex);
+        buffer.name = name;
+    }
+
+private:
+    struct Event {
+        std::string name;
+        const char *category;
+        long long start; // Microseconds since the recording started
+        long long duration; // Microseconds
+    };
+
+    struct ThreadBuffer {
+        std::mutex mutex; // Only contended while the trace is written
+        size_t id = 0;
+        std::string name;
+        std::vector<Event> events;
+    };
+
+    Profiler() = default;
+
+    ThreadBuffer &getThreadBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> guard(mutex);
+            buffer->id = buffers.size();
+            buffer->name = "Thread " + std::to_string(buffer->id);
+            buffers.emplace_back(buffer);
+        }
+        return *buffer;
+    }
+
+    static std::string escape(std::string_view str) {
+        std::string ret;
+        for (auto c: str) {
+            if (c == '"' || c == '\\')
+                ret += '\\';
+            ret += c;
+        }
+        return ret;
+    }
+
+    static inline std::atomic<bool> enabled = false;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // Kept after their thread exits so that its zones are written
+    std::atomic<Clock::rep> origin = 0; // The time since the epoch of the clock when the recording started
+};
+
+/**
+ * Records the lifetime of the zone object when profiling is enabled.
+ *
+ * The name must outlive the zone.
+ */
+class ProfileZone {
+public:
+    explicit ProfileZone(std::string_view name, const char *category = "foxtrot")
+            : name(name), category(category) {
+        if (Profiler::isEnabled()) {
+            active = true;
+            start = Profiler::Clock::now();
+        }
+    }
+
+    ProfileZone(const ProfileZone &other) = delete;
+
+    ProfileZone &operator=(const ProfileZone &other) = delete;
+
+    ~ProfileZone() {
+        if (active)
+            Profiler::getDefaultProfiler().record(name, category, start, Profiler::Clock::now());
+    }
+
+private:
+    std::string_view name;
+    const char *category;
+    bool active = false;
+    Profiler::Clock::time_point start;
+};
+
+#endif //FOXTROT_PROFILER_HPP
@@ -0,0 +1,51 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_ASSETS_HPP
+#define FOXTROT_ASSETS_HPP
+
+#include <array>
+
+#include "xng/xng.hpp"
+
+#include "assetmanifest.hpp" // Generated by cmake/GenerateAssetManifest.cmake
+
+using namespace xng;
+
+namespace Assets {
+    /**
+     * Callers own the handles they create from the uri, so that assets are only kept loaded by the levels
+     * and entities which use them and can be released by the residency of the level.
+     *
+     * @param id
+     * @return The uri of the asset, the uris are parsed once on first use
+     */
+    inline const Uri &uri(AssetID id) {
+        static const auto table = []() {
+            std::array<Uri, ASSET_COUNT> ret;
+            for (size_t i = 0; i < ASSET_COUNT; i++) {
+                ret[i] = Uri(ASSET_PATHS[i]);
+            }
+            return ret;
+        }();
+        return table.at(id);
+    }
+}
+
+#endif //FOXTROT_ASSETS_HPP
@@ -0,0 +1,116 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CACHINGPARSER_HPP
+#define FOXTROT_CACHINGPARSER_HPP
+
+#include "xng/xng.hpp"
+
+#include "resource/decodecache.hpp"
+
+using namespace xng;
+
+/**
+ * Wraps a parser for a single image or audio resource and stores the decoded result in the decode cache.
+ *
+ * Subsequent reads of the same encoded data are served from the cache without invoking the wrapped parser.
+ * Bundles containing anything other than a single ImageRGBA or Audio resource are passed through unchanged.
+ */
+class CachingParser : public ResourceParser {
+public:
+    CachingParser(std::unique_ptr<ResourceParser> parser, std::shared_ptr<DecodeCache> cache)
+            : parser(std::move(parser)), cache(std::move(cache)) {}
+
+    ResourceBundle read(const std::vector<char> &buffer,
+                        const std::string &hint,
+                        const std::string &path,
+                        Archive *archive) const override {
+        auto key = DecodeCache::hash({reinterpret_cast<const uint8_t *>(buffer.data()), buffer.size()});
+
+        auto entry = cache->load(key);
+        if (entry) {
+            auto resource = createResource(*entry);
+            if (resource) {
+                ResourceBundle ret;
+                ret.add("", std::move(resource));
+                return ret;
+            }
+        }
+
+        auto ret = parser->read(buffer, hint, path, archive);
+        if (ret.assets.size() == 1 && ret.assets.begin()->first.empty()) {
+            storeResource(key, *ret.assets.begin()->second);
+        }
+        return ret;
+    }
+
+    const std::set<std::string> &getSupportedFormats() const override {
+        return parser->getSupportedFormats();
+    }
+
+private:
+    static_assert(sizeof(ColorRGBA) == 4);
+
+    static std::unique_ptr<Resource> createResource(const DecodeCache::Entry &entry) {
+        auto &header = entry.getHeader();
+        auto data = entry.getData();
+        switch (header.type) {
+            case DecodeCache::ENTRY_IMAGE_RGBA: {
+                auto width = static_cast<int>(header.parameters[0]);
+                auto height = static_cast<int>(header.parameters[1]);
+                if (data.size() != static_cast<size_t>(width) * height * sizeof(ColorRGBA))
+                    return nullptr;
+                std::vector<ColorRGBA> pixels(static_cast<size_t>(width) * height);
+                std::memcpy(pixels.data(), data.data(), data.size());
+                return std::make_unique<ImageRGBA>(width, height, std::move(pixels));
+            }
+            case DecodeCache::ENTRY_AUDIO_PCM: {
+                auto ret = std::make_unique<Audio>();
+                ret->format = static_cast<AudioFormat>(header.parameters[0]);
+                ret->frequency = static_cast<int>(header.parameters[1]);
+                ret->buffer.assign(data.begin(), data.end());
+                return ret;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    void storeResource(uint64_t key, const Resource &resource) const {
+        DecodeCache::Header header;
+        if (auto *image = dynamic_cast<const ImageRGBA *>(&resource)) {
+            auto &pixels = image->getBuffer();
+            header.type = DecodeCache::ENTRY_IMAGE_RGBA;
+            header.parameters[0] = image->getWidth();
+            header.parameters[1] = image->getHeight();
+            cache->store(key, header, {reinterpret_cast<const uint8_t *>(pixels.data()),
+                                       pixels.size() * sizeof(ColorRGBA)});
+        } else if (auto *audio = dynamic_cast<const Audio *>(&resource)) {
+            header.type = DecodeCache::ENTRY_AUDIO_PCM;
+            header.parameters[0] = audio->format;
+            header.parameters[1] = audio->frequency;
+            cache->store(key, header, audio->buffer);
+        }
+    }
+
+    std::unique_ptr<ResourceParser> parser;
+    std::shared_ptr<DecodeCache> cache;
+};
+
+#endif //FOXTROT_CACHINGPARSER_HPP
@@ -0,0 +1,289 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_DECODECACHE_HPP
+#define FOXTROT_DECODECACHE_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <span>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#ifdef __unix__
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#endif
+
+/**
+ * A directory of decoded resource data keyed by the hash of the encoded data.
+ *
+ * Each entry is a single file consisting of a fixed size header followed by the raw decoded bytes
+ * so that it can be memory mapped and used without parsing.
+ * The total size of the directory is bounded, the least recently used entries are evicted
+ * using the modification time of the files as the access time.
+ */
+class DecodeCache {
+public:
+    enum EntryType : uint32_t {
+        ENTRY_IMAGE_RGBA = 1,
+        ENTRY_AUDIO_PCM = 2,
+    };
+
+    struct Header {
+        char magic[4] = {'F', 'X', 'D', 'C'};
+        uint32_t version = VERSION;
+        EntryType type = ENTRY_IMAGE_RGBA;
+        uint32_t parameters[3] = {}; // Width and height for images, format and frequency for audio
+        uint64_t size = 0; // The number of bytes following the header
+    };
+
+    /**
+     * A read only view of a cache entry, the data is memory mapped if supported.
+     */
+    class Entry {
+    public:
+        Entry() = default;
+
+        Entry(const Entry &other) = delete;
+
+        Entry(Entry &&other) noexcept {
+            *this = std::move(other);
+        }
+
+        Entry &operator=(Entry &&other) noexcept {
+            release();
+            header = other.header;
+            mapping = other.mapping;
+            mappingSize = other.mappingSize;
+            buffer = std::move(other.buffer);
+            other.mapping = nullptr;
+            other.mappingSize = 0;
+            return *this;
+        }
+
+        ~Entry() {
+            release();
+        }
+
+        const Header &getHeader() const {
+            return header;
+        }
+
+        std::span<const uint8_t> getData() const {
+            if (mapping != nullptr)
+                return {static_cast<const uint8_t *>(mapping) + sizeof(Header), header.size};
+            else
+                return buffer;
+        }
+
+    private:
+        friend class DecodeCache;
+
+        void release() {
+#ifdef __unix__
+            if (mapping != nullptr)
+                munmap(mapping, mappingSize);
+#endif
+            mapping = nullptr;
+            mappingSize = 0;
+        }
+
+        Header header;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        std::vector<uint8_t> buffer;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    DecodeCache(std::filesystem::path directory, uintmax_t maxSize)
+            : directory(std::move(directory)), maxSize(maxSize) {
+        std::filesystem::create_directories(this->directory);
+        for (auto &file: std::filesystem::directory_iterator(this->directory)) {
+            if (file.is_regular_file())
+                size += file.file_size();
+        }
+    }
+
+    static uint64_t hash(std::span<const uint8_t> data) {
+        // FNV-1a
+        uint64_t ret = 14695981039346656037ull;
+        for (auto &b: data) {
+            ret ^= b;
+            ret *= 1099511628211ull;
+        }
+        return ret;
+    }
+
+    std::optional<Entry> load(uint64_t key) {
+        auto path = getPath(key);
+
+        Entry ret;
+        if (!read(path, ret)) {
+            misses++;
+            return {};
+        }
+
+        // Mark as recently used
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+        hits++;
+        return ret;
+    }
+
+    void store(uint64_t key, Header header, std::span<const uint8_t> data) {
+        header.size = data.size();
+
+        auto path = getPath(key);
+        auto tmpPath = path;
+        tmpPath += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream stream(tmpPath, std::ios::binary);
+            stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+            stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!stream)
+                return;
+        }
+
+        // An existing entry for the key is replaced, its size is subtracted
+        std::lock_guard<std::mutex> guard(mutex);
+        std::error_code ec;
+        auto previousSize = std::filesystem::file_size(path, ec);
+        if (ec)
+            previousSize = 0;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+
+        size -= std::min(size, previousSize);
+        size += sizeof(Header) + data.size();
+        if (size > maxSize)
+            evict();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::error_code ec;
+        for (auto &file: std::filesystem::directory_iterator(directory)) {
+            std::filesystem::remove(file.path(), ec);
+        }
+        size = 0;
+    }
+
+    uintmax_t getSize() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return size;
+    }
+
+    size_t getHits() const {
+        return hits;
+    }
+
+    size_t getMisses() const {
+        return misses;
+    }
+
+private:
+    std::filesystem::path getPath(uint64_t key) const {
+        std::stringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << key;
+        return directory / (stream.str() + ".bin");
+    }
+
+    static bool read(const std::filesystem::path &path, Entry &entry) {
+#ifdef __unix__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            close(fd);
+            return false;
+        }
+        auto *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED)
+            return false;
+        entry.mapping = ptr;
+        entry.mappingSize = st.st_size;
+        std::memcpy(&entry.header, ptr, sizeof(Header));
+        return validate(entry.header, entry.mappingSize);
+#else
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.read(reinterpret_cast<char *>(&entry.header), sizeof(Header)))
+            return false;
+        entry.buffer.resize(entry.header.size);
+        if (!stream.read(reinterpret_cast<char *>(entry.buffer.data()), entry.header.size))
+            return false;
+        return validate(entry.header, sizeof(Header) + entry.header.size);
+#endif
+    }
+
+    static bool validate(const Header &header, size_t fileSize) {
+        return std::memcmp(header.magic, Header().magic, sizeof(header.magic)) == 0
+               && header.version == VERSION
+               && sizeof(Header) + header.size == fileSize;
+    }
+
+    /**
+     * Delete the least recently used entries until the size is below 90% of the maximum size.
+     */
+    void evict() {
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+        std::error_code ec;
+        for (auto &file: std::filesystem::directory_iterator(directory)) {
+            if (file.is_regular_file() && file.path().extension() == ".bin")
+                files.emplace_back(file.last_write_time(), file.path());
+        }
+        std::sort(files.begin(), files.end());
+        for (auto &file: files) {
+            if (size <= maxSize / 10 * 9)
+                break;
+            auto fileSize = std::filesystem::file_size(file.second, ec);
+            if (!ec && std::filesystem::remove(file.second, ec))
+                size -= fileSize;
+        }
+    }
+
+    std::filesystem::path directory;
+    uintmax_t maxSize;
+
+    std::mutex mutex;
+    uintmax_t size = 0;
+
+    std::atomic<size_t> hits = 0;
+    std::atomic<size_t> misses = 0;
+};
+
+#endif //FOXTROT_DECODECACHE_HPP
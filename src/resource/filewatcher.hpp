@@ -0,0 +1,144 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_FILEWATCHER_HPP
+#define FOXTROT_FILEWATCHER_HPP
+
+#include <filesystem>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#endif
+
+/**
+ * Watches a directory tree for modified files.
+ *
+ * Only completed writes and files moved into the tree are reported, editors which save by renaming a temporary file
+ * report the final path once. Created and deleted files are not reported because created files are still being written.
+ *
+ * Uses inotify on linux, on other platforms no changes are reported.
+ * The events are read on a background thread and collected until pollChanges is called.
+ */
+class FileWatcher {
+public:
+    explicit FileWatcher(std::filesystem::path directory)
+            : directory(std::move(directory)) {
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+            return;
+        addWatch(this->directory);
+        for (auto &entry: std::filesystem::recursive_directory_iterator(this->directory)) {
+            if (entry.is_directory())
+                addWatch(entry.path());
+        }
+        thread = std::thread([this]() { run(); });
+#endif
+    }
+
+    ~FileWatcher() {
+        shutdown = true;
+        if (thread.joinable())
+            thread.join();
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    FileWatcher(const FileWatcher &other) = delete;
+
+    FileWatcher &operator=(const FileWatcher &other) = delete;
+
+    bool isSupported() const {
+        return thread.joinable();
+    }
+
+    /**
+     * @return The paths relative to the watched directory which have been modified since the last call
+     */
+    std::set<std::string> pollChanges() {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto ret = std::move(changes);
+        changes.clear();
+        return ret;
+    }
+
+private:
+#ifdef __linux__
+    void addWatch(const std::filesystem::path &path) {
+        auto wd = inotify_add_watch(fd,
+                                    path.c_str(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0)
+            watches[wd] = path;
+    }
+
+    void run() {
+        alignas(inotify_event) char buffer[4096];
+        pollfd pfd{fd, POLLIN, 0};
+        while (!shutdown) {
+            if (poll(&pfd, 1, 100) <= 0)
+                continue;
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char *ptr = buffer; ptr < buffer + len;) {
+                    auto *event = reinterpret_cast<inotify_event *>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    auto it = watches.find(event->wd);
+                    if (it == watches.end() || event->len == 0)
+                        continue;
+
+                    auto path = it->second / event->name;
+                    if (event->mask & IN_ISDIR) {
+                        addWatch(path);
+                        continue;
+                    }
+
+                    std::lock_guard<std::mutex> guard(mutex);
+                    changes.insert(std::filesystem::relative(path, directory).generic_string());
+                }
+            }
+        }
+    }
+
+    int fd = -1;
+    std::map<int, std::filesystem::path> watches; // Only accessed by the watcher thread after construction
+#endif
+
+    std::filesystem::path directory;
+
+    std::thread thread;
+    std::atomic<bool> shutdown = false;
+
+    std::mutex mutex;
+    std::set<std::string> changes;
+};
+
+#endif //FOXTROT_FILEWATCHER_HPP
@@ -0,0 +1,76 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_HOTRELOADER_HPP
+#define FOXTROT_HOTRELOADER_HPP
+
+#include <algorithm>
+#include <string_view>
+
+#include "xng/xng.hpp"
+
+#include "assetmanifest.hpp"
+
+#include "resource/filewatcher.hpp"
+
+using namespace xng;
+
+/**
+ * Reports the modified asset files, the listener is only invoked from update() which is called at a frame boundary.
+ *
+ * Files which are not part of the asset manifest (editor backups, temporary files) are ignored.
+ */
+class HotReloader {
+public:
+    class Listener {
+    public:
+        /**
+         * @param files The modified files, relative to the asset directory
+         */
+        virtual void onAssetsChanged(const std::set<std::string> &files) = 0;
+    };
+
+    HotReloader(const std::filesystem::path &directory, Listener &listener)
+            : watcher(directory),
+              listener(listener) {}
+
+    void update() {
+        auto changes = watcher.pollChanges();
+        std::erase_if(changes, [](const std::string &file) { return !isAsset(file); });
+        if (!changes.empty()) {
+            listener.onAssetsChanged(changes);
+        }
+    }
+
+    bool isSupported() const {
+        return watcher.isSupported();
+    }
+
+private:
+    static bool isAsset(std::string_view file) {
+        return std::any_of(std::begin(ASSET_PATHS), std::end(ASSET_PATHS), [&](const char *path) {
+            return file == path;
+        });
+    }
+
+    FileWatcher watcher;
+    Listener &listener;
+};
+
+#endif //FOXTROT_HOTRELOADER_HPP
@@ -0,0 +1,104 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_RESIDENCYSET_HPP
+#define FOXTROT_RESIDENCYSET_HPP
+
+#include <variant>
+#include <map>
+#include <span>
+#include <string_view>
+
+#include "xng/xng.hpp"
+
+#include "resource/assets.hpp"
+
+using namespace xng;
+
+/**
+ * The assets a level requires to be resident while it is loaded.
+ */
+class ResidencySet {
+public:
+    typedef std::variant<ResourceHandle<ImageRGBA>,
+            ResourceHandle<Sprite>,
+            ResourceHandle<SpriteAnimation>,
+            ResourceHandle<ColliderDesc>,
+            ResourceHandle<Audio>,
+            ResourceHandle<RawResource>> Handle;
+
+    static constexpr const char *TYPE_NAMES[std::variant_size_v<Handle>] = {
+            "Image",
+            "Sprite",
+            "SpriteAnimation",
+            "Collider",
+            "Audio",
+            "Raw"
+    };
+
+    template<typename T>
+    ResidencySet &add(AssetID id) {
+        // Not taken from the Assets table, whose handles are never released, so that evicted assets are unloaded
+        assets[id] = [](AssetID asset) -> Handle { return ResourceHandle<T>(Assets::uri(asset)); };
+        return *this;
+    }
+
+    template<typename T>
+    ResidencySet &add(std::initializer_list<AssetID> ids) {
+        for (auto id: ids) {
+            add<T>(id);
+        }
+        return *this;
+    }
+
+    /**
+     * Add the assets referenced by a scene, see the <scene>_REFERENCES lists of the asset manifest.
+     * The resource type is derived from the asset directory, assets of other directories are ignored.
+     */
+    ResidencySet &addReferences(std::span<const AssetID> ids) {
+        for (auto id: ids) {
+            std::string_view path(ASSET_PATHS[id]);
+            if (path.starts_with("images/"))
+                add<ImageRGBA>(id);
+            else if (path.starts_with("sprites/"))
+                add<Sprite>(id);
+            else if (path.starts_with("animations/"))
+                add<SpriteAnimation>(id);
+            else if (path.starts_with("colliders/"))
+                add<ColliderDesc>(id);
+            else if (path.starts_with("sound/"))
+                add<Audio>(id);
+            else if (path.starts_with("fonts/"))
+                add<RawResource>(id);
+        }
+        return *this;
+    }
+
+    /**
+     * @return The asset ids and the functions creating the handles that keep each asset loaded.
+     */
+    const std::map<AssetID, Handle (*)(AssetID)> &getAssets() const {
+        return assets;
+    }
+
+private:
+    std::map<AssetID, Handle (*)(AssetID)> assets;
+};
+
+#endif //FOXTROT_RESIDENCYSET_HPP
@@ -0,0 +1,276 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_RESOURCERESIDENCY_HPP
+#define FOXTROT_RESOURCERESIDENCY_HPP
+
+#include <list>
+#include <mutex>
+#include <atomic>
+
+#include "xng/xng.hpp"
+
+#include "resource/residencyset.hpp"
+#include "levelname.hpp"
+
+using namespace xng;
+
+/**
+ * Keeps the residency sets of levels loaded.
+ *
+ * Each asset is reference counted by the levels which declared it.
+ * Assets which are no longer referenced stay resident, so that switching back to a level is cheap,
+ * until the resident bytes exceed the budget at which point the least recently released assets are unloaded.
+ *
+ * Only memory which eviction can free is charged against the budget:
+ * Sprites are charged the image they reference, images shared by several sprites such as atlases are charged once.
+ * Evicting an asset only drops the reference held by the residency, the cached scene template of a level keeps
+ * the assets of its scene loaded. The owner of the template cache should drop the templates of released levels
+ * when getEvictionCount changes.
+ *
+ * Must be used from the main thread, the sizes of newly resident assets are measured on the thread pool.
+ */
+class ResourceResidency {
+public:
+    explicit ResourceResidency(size_t budget) : budget(budget) {}
+
+    ~ResourceResidency() {
+        for (auto &task: measureTasks) {
+            task->join();
+        }
+    }
+
+    /**
+     * Reference the assets of the set for the given level, replacing the set previously acquired for the level.
+     * Assets which are not yet resident start loading asynchronously.
+     */
+    void acquire(LevelID level, const ResidencySet &set) {
+        std::vector<std::pair<AssetID, ResidencySet::Handle>> unmeasured;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            std::set<AssetID> ids;
+            for (auto &pair: set.getAssets()) {
+                auto it = entries.find(pair.first);
+                if (it == entries.end()) {
+                    it = entries.emplace(pair.first, Entry{pair.second(pair.first)}).first;
+                    unmeasured.emplace_back(pair.first, it->second.handle);
+                } else if (it->second.references == 0) {
+                    unreferenced.erase(it->second.lruIterator);
+                }
+                it->second.references++;
+                ids.insert(pair.first);
+            }
+            // Released after referencing the new set so that shared assets are never evicted in between
+            releaseLevel(level);
+            levels[level] = std::move(ids);
+        }
+
+        if (!unmeasured.empty()) {
+            pendingMeasurements++;
+            measureTasks.emplace_back(ThreadPool::getPool().addTask([this, unmeasured]() {
+                measure(unmeasured);
+                pendingMeasurements--;
+            }));
+        }
+    }
+
+    /**
+     * Drop the references of the given level, the assets stay resident until they are evicted.
+     */
+    void release(LevelID level) {
+        std::lock_guard<std::mutex> guard(mutex);
+        releaseLevel(level);
+        enforceBudget();
+    }
+
+    /**
+     * Evict assets if the sizes measured since the last call exceeded the budget.
+     */
+    void update() {
+        if (pendingMeasurements == 0 && !measureTasks.empty()) {
+            for (auto &task: measureTasks) {
+                task->join();
+            }
+            measureTasks.clear();
+        }
+        std::lock_guard<std::mutex> guard(mutex);
+        enforceBudget();
+    }
+
+    void setBudget(size_t value) {
+        std::lock_guard<std::mutex> guard(mutex);
+        budget = value;
+        enforceBudget();
+    }
+
+    size_t getBudget() const {
+        return budget;
+    }
+
+    /**
+     * @return The measured resident bytes of each resource type, including unreferenced assets
+     */
+    std::map<std::string, size_t> getResidentBytes() {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::map<std::string, size_t> ret;
+        for (auto &pair: entries) {
+            ret[ResidencySet::TYPE_NAMES[pair.second.handle.index()]] += pair.second.size;
+        }
+        for (auto &pair: images) {
+            ret[ResidencySet::TYPE_NAMES[0]] += pair.second.size;
+        }
+        return ret;
+    }
+
+    size_t getTotalBytes() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return totalBytes;
+    }
+
+    size_t getUnreferencedCount() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return unreferenced.size();
+    }
+
+    /**
+     * @return The number of assets evicted so far
+     */
+    size_t getEvictionCount() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return evictionCount;
+    }
+
+private:
+    struct Entry {
+        ResidencySet::Handle handle;
+        size_t references = 0;
+        size_t size = 0; // Excluding the size of the image
+        std::string image; // The uri of the image charged for the asset, empty if none
+        bool measured = false;
+        std::list<AssetID>::iterator lruIterator;
+    };
+
+    struct SharedImage {
+        size_t references = 0;
+        size_t size = 0;
+    };
+
+    struct Measurement {
+        size_t size = 0;
+        std::string image;
+        size_t imageSize = 0;
+    };
+
+    static size_t getImageSize(const ImageRGBA &image) {
+        return static_cast<size_t>(image.getWidth()) * image.getHeight() * sizeof(ColorRGBA);
+    }
+
+    static Measurement getSize(AssetID id, const ResidencySet::Handle &handle) {
+        return std::visit([id](auto &h) -> Measurement {
+            auto &resource = h.get();
+            using T = std::decay_t<decltype(resource)>;
+            if constexpr (std::is_same_v<T, ImageRGBA>) {
+                return {0, Assets::uri(id).toString(), getImageSize(resource)};
+            } else if constexpr (std::is_same_v<T, Sprite>) {
+                // The sprite keeps its whole (possibly shared) image loaded
+                return {sizeof(T), resource.image.getUri().toString(), getImageSize(resource.image.get())};
+            } else if constexpr (std::is_same_v<T, Audio>) {
+                return {resource.buffer.size()};
+            } else if constexpr (std::is_same_v<T, RawResource>) {
+                return {resource.bytes.size()};
+            } else {
+                return {sizeof(T)};
+            }
+        }, handle);
+    }
+
+    // Requires mutex to be locked
+    void releaseLevel(LevelID level) {
+        auto it = levels.find(level);
+        if (it == levels.end())
+            return;
+        for (auto id: it->second) {
+            auto &entry = entries.at(id);
+            if (--entry.references == 0) {
+                entry.lruIterator = unreferenced.insert(unreferenced.end(), id);
+            }
+        }
+        levels.erase(it);
+    }
+
+    // Invoked from the thread pool
+    void measure(const std::vector<std::pair<AssetID, ResidencySet::Handle>> &handles) {
+        for (auto &pair: handles) {
+            Measurement measurement;
+            try {
+                measurement = getSize(pair.first, pair.second);
+            } catch (const std::exception &) {
+                // Assets which fail to load do not occupy memory
+            }
+            std::lock_guard<std::mutex> guard(mutex);
+            auto it = entries.find(pair.first);
+            if (it == entries.end() || it->second.measured)
+                continue;
+            it->second.measured = true;
+            it->second.size = measurement.size;
+            totalBytes += measurement.size;
+            if (!measurement.image.empty()) {
+                it->second.image = measurement.image;
+                auto &image = images[measurement.image];
+                if (image.references++ == 0) {
+                    image.size = measurement.imageSize;
+                    totalBytes += image.size;
+                }
+            }
+        }
+    }
+
+    // Requires mutex to be locked
+    void enforceBudget() {
+        while (totalBytes > budget && !unreferenced.empty()) {
+            auto it = entries.find(unreferenced.front());
+            totalBytes -= it->second.size;
+            if (!it->second.image.empty()) {
+                auto image = images.find(it->second.image);
+                if (--image->second.references == 0) {
+                    totalBytes -= image->second.size;
+                    images.erase(image);
+                }
+            }
+            entries.erase(it);
+            unreferenced.pop_front();
+            evictionCount++;
+        }
+    }
+
+    size_t budget;
+
+    std::mutex mutex;
+    std::map<AssetID, Entry> entries;
+    std::map<LevelID, std::set<AssetID>> levels;
+    std::map<std::string, SharedImage> images; // The images charged for the resident assets by uri
+    std::list<AssetID> unreferenced; // The least recently released asset is at the front
+    size_t totalBytes = 0;
+    size_t evictionCount = 0;
+
+    std::vector<std::shared_ptr<Task>> measureTasks;
+    std::atomic<size_t> pendingMeasurements = 0;
+};
+
+#endif //FOXTROT_RESOURCERESIDENCY_HPP
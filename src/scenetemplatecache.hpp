@@ -0,0 +1,131 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_SCENETEMPLATECACHE_HPP
+#define FOXTROT_SCENETEMPLATECACHE_HPP
+
+#include <mutex>
+
+#include "xng/xng.hpp"
+
+#include "levelname.hpp"
+
+using namespace xng;
+
+/**
+ * Keeps the parsed scene of each level as an immutable template.
+ *
+ * Instantiating a level copies the template into a fresh scene instead of reading and parsing the scene resource again.
+ * The cache is accessed from the level load tasks and therefore synchronized.
+ */
+class SceneTemplateCache {
+public:
+    struct Entry {
+        Uri uri;
+        std::shared_ptr<const EntityScene> scene;
+        size_t size; // The approximate size of the template in bytes
+    };
+
+    /**
+     * Create a new scene for the given level, the scene resource is only loaded if no template is cached.
+     *
+     * @param level
+     * @param uri The scene resource to load if the level does not have a template
+     * @return The new scene instance
+     */
+    std::shared_ptr<EntityScene> instantiate(LevelID level, const Uri &uri) {
+        return std::make_shared<EntityScene>(*getTemplate(level, uri));
+    }
+
+    std::shared_ptr<const EntityScene> getTemplate(LevelID level, const Uri &uri) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto it = templates.find(level);
+            if (it != templates.end()) {
+                return it->second.scene;
+            }
+        }
+
+        auto handle = ResourceHandle<EntityScene>(uri);
+        auto scene = std::make_shared<const EntityScene>(handle.get());
+        auto size = estimateSize(*scene);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = templates.find(level);
+        if (it == templates.end()) {
+            templates[level] = Entry{uri, scene, size};
+            memoryUsage += size;
+            return scene;
+        } else {
+            // Another thread has created the template in the meantime.
+            return it->second.scene;
+        }
+    }
+
+    bool contains(LevelID level) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return templates.find(level) != templates.end();
+    }
+
+    void evict(LevelID level) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = templates.find(level);
+        if (it != templates.end()) {
+            memoryUsage -= it->second.size;
+            templates.erase(it);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(mutex);
+        templates.clear();
+        memoryUsage = 0;
+    }
+
+    std::map<LevelID, Entry> getEntries() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return templates;
+    }
+
+    /**
+     * @return The approximate number of bytes held by the cached templates
+     */
+    size_t getMemoryUsage() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return memoryUsage;
+    }
+
+private:
+    /**
+     * The serialized size of the scene is used as an approximation of its memory footprint.
+     */
+    static size_t estimateSize(const EntityScene &scene) {
+        Message message;
+        scene >> message;
+        std::stringstream stream;
+        JsonProtocol().serialize(stream, message);
+        return static_cast<size_t>(stream.tellp());
+    }
+
+    std::mutex mutex;
+    std::map<LevelID, Entry> templates;
+    size_t memoryUsage = 0;
+};
+
+#endif //FOXTROT_SCENETEMPLATECACHE_HPP
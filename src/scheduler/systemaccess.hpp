@@ -0,0 +1,89 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_SYSTEMACCESS_HPP
+#define FOXTROT_SYSTEMACCESS_HPP
+
+#include <set>
+#include <typeindex>
+#include <optional>
+#include <string>
+
+/**
+ * The component types a system reads and writes, used by the SystemScheduler to decide which systems may run concurrently.
+ *
+ * Any type can be declared, event types are declared to order the systems sending events before the systems
+ * which handle them in their update.
+ * Systems which create or destroy entities or components are structural and conflict with every other system.
+ */
+class SystemAccess {
+public:
+    template<typename... T>
+    SystemAccess &reads() {
+        (readTypes.insert(typeid(T)), ...);
+        return *this;
+    }
+
+    template<typename... T>
+    SystemAccess &writes() {
+        (writeTypes.insert(typeid(T)), ...);
+        return *this;
+    }
+
+    SystemAccess &structural() {
+        isStructural = true;
+        return *this;
+    }
+
+    bool getStructural() const {
+        return isStructural;
+    }
+
+    bool checkRead(const std::type_index &type) const {
+        return isStructural || readTypes.find(type) != readTypes.end() || checkWrite(type);
+    }
+
+    bool checkWrite(const std::type_index &type) const {
+        return isStructural || writeTypes.find(type) != writeTypes.end();
+    }
+
+    /**
+     * @return A description of the conflicting access if the systems may not run concurrently
+     */
+    std::optional<std::string> getConflict(const SystemAccess &other) const {
+        if (isStructural || other.isStructural)
+            return "structural access";
+        for (auto &type: writeTypes) {
+            if (other.checkRead(type))
+                return std::string("write of ") + type.name();
+        }
+        for (auto &type: other.writeTypes) {
+            if (checkRead(type))
+                return std::string("write of ") + type.name();
+        }
+        return std::nullopt;
+    }
+
+private:
+    std::set<std::type_index> readTypes;
+    std::set<std::type_index> writeTypes;
+    bool isStructural = false;
+};
+
+#endif //FOXTROT_SYSTEMACCESS_HPP
@@ -0,0 +1,340 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_SYSTEMSCHEDULER_HPP
+#define FOXTROT_SYSTEMSCHEDULER_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "xng/xng.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/commandbuffer.hpp"
+
+#include "profile/profiler.hpp"
+#include "profile/allocationtracker.hpp"
+
+using namespace xng;
+
+/**
+ * Runs systems concurrently on the thread pool according to their declared component access.
+ *
+ * Systems are added in execution order with the names of the systems they run after.
+ * A system whose access conflicts with an earlier system which it is not ordered after (directly or transitively)
+ * is rejected when added, so every pair of conflicting systems has a defined order.
+ * Systems without a path between them in the resulting graph run concurrently.
+ *
+ * The scheduler is a system itself and is added to a pipeline in place of the systems it runs.
+ * The calling thread takes part in running the systems so that the update completes
+ * even if no pool thread is available.
+ *
+ * Systems defer their structural changes to the CommandBuffer of the scheduler which is applied after all systems ran.
+ * A null system keeps its place in the graph but is not run, so that the graph is the same for every configuration.
+ *
+ * When verifying, the systems run sequentially and the component writes and structural changes
+ * observed through the scene listener are checked against the declared access.
+ * The violations are only collected, see getViolations. Reads cannot be observed and are not verified.
+ */
+class SystemScheduler : public System, public EntityScene::Listener {
+public:
+    void add(const std::string &name,
+             std::shared_ptr<System> system,
+             SystemAccess access,
+             const std::vector<std::string> &after = {}) {
+        if (started)
+            throw std::runtime_error("Systems cannot be added to a running scheduler");
+        if (indices.find(name) != indices.end())
+            throw std::runtime_error("System " + name + " is already added to the scheduler");
+
+        Node node;
+        node.name = name;
+        node.system = std::move(system);
+        node.access = std::move(access);
+        node.ancestors.resize(nodes.size(), false);
+
+        for (auto &dependency: after) {
+            auto it = indices.find(dependency);
+            if (it == indices.end())
+                throw std::runtime_error("System " + name + " runs after unknown system " + dependency);
+            node.dependencies++;
+            node.ancestors.at(it->second) = true;
+            for (size_t i = 0; i < nodes.at(it->second).ancestors.size(); i++) {
+                if (nodes.at(it->second).ancestors.at(i))
+                    node.ancestors.at(i) = true;
+            }
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (node.ancestors.at(i))
+                continue;
+            auto conflict = node.access.getConflict(nodes.at(i).access);
+            if (conflict) {
+                throw std::runtime_error("System " + name + " conflicts with " + nodes.at(i).name
+                                         + " (" + *conflict + ") and must run after it");
+            }
+        }
+
+        auto index = nodes.size();
+        for (auto &dependency: after) {
+            nodes.at(indices.at(dependency)).successors.emplace_back(index);
+        }
+        indices[name] = index;
+        nodes.emplace_back(std::move(node));
+    }
+
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        started = true;
+        scene.addListener(*this);
+        for (auto &node: nodes) {
+            if (node.system)
+                node.system->start(scene, eventBus);
+        }
+    }
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        for (auto &node: nodes) {
+            if (node.system)
+                node.system->stop(scene, eventBus);
+        }
+        commands.clear();
+        scene.removeListener(*this);
+        started = false;
+    }
+
+    void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        if (nodes.empty())
+            return;
+
+        if (verify) {
+            // Added systems only run after earlier systems so the order of addition is a valid sequential order
+            for (size_t i = 0; i < nodes.size(); i++) {
+                if (!nodes.at(i).system)
+                    continue;
+                verifiedNode = i;
+                ProfileZone zone(nodes.at(i).name, "system");
+                AllocationScope allocationScope(nodes.at(i).name);
+                nodes.at(i).system->update(deltaTime, scene, eventBus);
+            }
+            verifiedNode = std::nullopt;
+            commands.apply(scene);
+            return;
+        }
+
+        auto run = std::make_shared<Run>();
+        run->nodes = &nodes;
+        run->deltaTime = deltaTime;
+        run->scene = &scene;
+        run->eventBus = &eventBus;
+        run->remaining = nodes.size();
+        for (size_t i = 0; i < nodes.size(); i++) {
+            run->dependencies.emplace_back(nodes.at(i).dependencies);
+            if (nodes.at(i).dependencies == 0)
+                run->ready.emplace_back(i);
+        }
+
+        spawnHelpers(run, run->ready.size() - 1);
+        work(run, true);
+
+        if (run->exception) {
+            commands.clear();
+            std::rethrow_exception(run->exception);
+        }
+
+        ProfileZone zone("Apply commands", "system");
+        commands.apply(scene);
+    }
+
+    /**
+     * @return The buffer for the structural changes of the systems, applied after each update
+     */
+    CommandBuffer &getCommands() {
+        return commands;
+    }
+
+    /**
+     * @return The names of the pairs of systems which have no ordering between them and therefore may run concurrently
+     */
+    std::vector<std::pair<std::string, std::string>> getConcurrentPairs() const {
+        std::vector<std::pair<std::string, std::string>> ret;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            for (size_t j = 0; j < i; j++) {
+                if (!nodes.at(i).ancestors.at(j))
+                    ret.emplace_back(nodes.at(j).name, nodes.at(i).name);
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @param value If true the systems run sequentially and their writes are checked against the declared access
+     */
+    void setVerify(bool value) {
+        verify = value;
+    }
+
+    bool getVerify() const {
+        return verify;
+    }
+
+    /**
+     * @return The descriptions of the undeclared accesses observed while verifying
+     */
+    const std::set<std::string> &getViolations() const {
+        return violations;
+    }
+
+    void onEntityCreate(const EntityHandle &entity) override {
+        checkAccess(std::nullopt);
+    }
+
+    void onEntityDestroy(const EntityHandle &entity) override {
+        checkAccess(std::nullopt);
+    }
+
+    void onComponentCreate(const EntityHandle &entity, const Component &component) override {
+        checkAccess(std::nullopt);
+    }
+
+    void onComponentDestroy(const EntityHandle &entity, const Component &component) override {
+        checkAccess(std::nullopt);
+    }
+
+    void onComponentUpdate(const EntityHandle &entity,
+                           const Component &oldComponent,
+                           const Component &newComponent) override {
+        checkAccess(newComponent.getType());
+    }
+
+private:
+    struct Node {
+        std::string name;
+        std::shared_ptr<System> system;
+        SystemAccess access;
+        size_t dependencies = 0;
+        std::vector<size_t> successors;
+        std::vector<bool> ancestors; // Indexed by the earlier nodes
+    };
+
+    // The state of one update, shared with the helper tasks which may still be queued in the pool after the update returned
+    struct Run {
+        std::mutex mutex;
+        std::condition_variable condition;
+        const std::vector<Node> *nodes = nullptr; // Only accessed while systems remain
+        DeltaTime deltaTime = 0;
+        EntityScene *scene = nullptr;
+        EventBus *eventBus = nullptr;
+        std::vector<size_t> dependencies; // The remaining dependencies by node
+        std::vector<size_t> ready;
+        size_t remaining = 0;
+        std::exception_ptr exception;
+    };
+
+    static void spawnHelpers(const std::shared_ptr<Run> &run, size_t count) {
+        static const size_t maxHelpers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        for (size_t i = 0; i < std::min(count, maxHelpers); i++) {
+            ThreadPool::getPool().addTask([run]() {
+                work(run, false);
+            });
+        }
+    }
+
+    /**
+     * Run ready systems until all systems have run, helpers return as soon as no system is ready.
+     */
+    static void work(const std::shared_ptr<Run> &run, bool caller) {
+        std::unique_lock<std::mutex> lock(run->mutex);
+        while (run->remaining > 0) {
+            if (run->ready.empty()) {
+                if (!caller)
+                    return;
+                run->condition.wait(lock);
+                continue;
+            }
+
+            auto index = run->ready.back();
+            run->ready.pop_back();
+            auto &node = run->nodes->at(index);
+            lock.unlock();
+
+            std::exception_ptr exception;
+            try {
+                if (node.system) {
+                    ProfileZone zone(node.name, "system");
+                    AllocationScope allocationScope(node.name);
+                    node.system->update(run->deltaTime, *run->scene, *run->eventBus);
+                }
+            } catch (...) {
+                exception = std::current_exception();
+            }
+
+            lock.lock();
+            if (exception && !run->exception)
+                run->exception = exception;
+            size_t released = 0;
+            for (auto &successor: node.successors) {
+                if (--run->dependencies.at(successor) == 0) {
+                    run->ready.emplace_back(successor);
+                    released++;
+                }
+            }
+            run->remaining--;
+            run->condition.notify_all();
+
+            // This thread continues with one of the released systems
+            if (released > 1) {
+                lock.unlock();
+                spawnHelpers(run, released - 1);
+                lock.lock();
+            }
+        }
+    }
+
+    void checkAccess(const std::optional<std::type_index> &type) {
+        if (!verifiedNode)
+            return;
+        auto &node = nodes.at(*verifiedNode);
+        if (node.access.getStructural())
+            return;
+        std::string violation;
+        if (!type) {
+            violation = node.name + " creates or destroys entities or components without structural access";
+        } else if (!node.access.checkWrite(*type)) {
+            violation = node.name + " writes undeclared " + type->name();
+        } else {
+            return;
+        }
+        violations.insert(violation);
+    }
+
+    std::vector<Node> nodes;
+    std::map<std::string, size_t> indices;
+
+    bool started = false;
+
+    CommandBuffer commands;
+
+    bool verify = false;
+    std::optional<size_t> verifiedNode; // The node which is running while verifying
+    std::set<std::string> violations;
+};
+
+#endif //FOXTROT_SYSTEMSCHEDULER_HPP
@@ -0,0 +1,217 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_FIXEDSTEPRUNTIME_HPP
+#define FOXTROT_FIXEDSTEPRUNTIME_HPP
+
+#include <cmath>
+
+#include "xng/xng.hpp"
+
+#include "simulation/transforminterpolator.hpp"
+#include "simulation/scenemirror.hpp"
+
+#include "profile/profiler.hpp"
+
+#include "stats/frametimerecorder.hpp"
+
+using namespace xng;
+
+/**
+ * Runs the simulation systems at a fixed rate on the thread pool while the render systems draw on the main thread.
+ *
+ * The render systems draw from a mirror of the render relevant components (the front buffer)
+ * while the simulation steps write into the scene (the back buffer).
+ *
+ * Each frame update() waits for the steps started in the previous frame, which is the sync point.
+ * The frame pipeline (input, camera, gui and audio) then runs on the scene with the moving bodies interpolated
+ * between the last two simulation steps and the result is copied to the mirror.
+ * Afterwards the simulation steps for the accumulated frame time are started on the thread pool
+ * and the render pipeline draws the mirror on the calling thread concurrently.
+ */
+class FixedStepRuntime {
+public:
+    typedef SceneMirror<TransformComponent,
+            RectTransformComponent,
+            CanvasComponent,
+            SpriteComponent,
+            TextComponent,
+            ButtonComponent> RenderState;
+
+    /**
+     * @param step The simulation step in seconds
+     * @param maxSteps The maximum number of steps per frame, frame time beyond that is dropped
+     * so that a slow frame does not cause even more simulation work in the next frame.
+     */
+    FixedStepRuntime(SystemPipeline framePipeline,
+                     SystemPipeline simulationPipeline,
+                     SystemPipeline renderPipeline,
+                     const std::shared_ptr<EntityScene> &scene,
+                     const std::shared_ptr<EventBus> &eventBus,
+                     DeltaTime step,
+                     int maxSteps)
+            : scene(scene),
+              frameRuntime({std::move(framePipeline)}, scene, eventBus),
+              simulationRuntime({std::move(simulationPipeline)}, scene, eventBus),
+              renderRuntime({std::move(renderPipeline)}, renderState.getScene(), eventBus),
+              step(step),
+              maxSteps(maxSteps) {}
+
+    FixedStepRuntime(const FixedStepRuntime &other) = delete;
+
+    FixedStepRuntime &operator=(const FixedStepRuntime &other) = delete;
+
+    ~FixedStepRuntime() {
+        // The steps capture this runtime, exceptions are only reported by stop()
+        if (simulationTask)
+            simulationTask->join();
+    }
+
+    void start() {
+        accumulator = 0;
+        interpolator.clear();
+        renderState.attach(*scene);
+        frameRuntime.start();
+        simulationRuntime.start();
+        renderRuntime.start();
+    }
+
+    void stop() {
+        awaitSimulation();
+        renderRuntime.stop();
+        simulationRuntime.stop();
+        frameRuntime.stop();
+        renderState.detach();
+        renderState.clear();
+    }
+
+    void update(DeltaTime deltaTime) {
+        awaitSimulation();
+
+        alpha = accumulator / step;
+
+        {
+            ProfileZone zone("Sync");
+            interpolator.apply(*scene, alpha);
+            frameRuntime.update(deltaTime);
+            renderState.copy(*scene);
+            interpolator.restore(*scene);
+        }
+
+        accumulator += deltaTime;
+        int steps = static_cast<int>(accumulator / step);
+        if (steps > maxSteps) {
+            droppedTime += static_cast<double>(steps - maxSteps) * step;
+            steps = maxSteps;
+        }
+        accumulator = std::fmod(accumulator, step);
+        totalSteps += steps;
+
+        if (steps > 0) {
+            simulationTask = ThreadPool::getPool().addTask([this, steps]() {
+                try {
+                    for (int i = 0; i < steps; i++) {
+                        ProfileZone zone("Simulation step");
+                        auto stepStart = FrameTimeRecorder::Clock::now();
+                        interpolator.capture(*scene);
+                        simulationRuntime.update(step);
+                        FrameTimeRecorder::getDefaultRecorder().record(FrameTimeRecorder::SIMULATION,
+                                                                       FrameTimeRecorder::Clock::now() - stepStart);
+                    }
+                } catch (...) {
+                    simulationException = std::current_exception();
+                }
+            });
+        }
+
+        ProfileZone zone("Render");
+        auto renderStart = FrameTimeRecorder::Clock::now();
+        renderRuntime.update(deltaTime);
+        FrameTimeRecorder::getDefaultRecorder().record(FrameTimeRecorder::RENDER,
+                                                       FrameTimeRecorder::Clock::now() - renderStart);
+    }
+
+    /**
+     * Wait for the running simulation steps, the scene may only be modified from outside the systems
+     * after this returns and before the next update.
+     *
+     * Exceptions thrown by the simulation systems are rethrown here.
+     */
+    void awaitSimulation() {
+        if (simulationTask) {
+            ProfileZone zone("Await simulation");
+            simulationTask->join();
+            simulationTask = nullptr;
+        }
+        if (simulationException) {
+            auto exception = simulationException;
+            simulationException = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    DeltaTime getStep() const {
+        return step;
+    }
+
+    /**
+     * @return The fraction of a simulation step the rendered state is ahead of the previous simulation state
+     */
+    float getAlpha() const {
+        return alpha;
+    }
+
+    /**
+     * @return The number of simulation steps since the runtime was created
+     */
+    unsigned long long getTotalSteps() const {
+        return totalSteps;
+    }
+
+    /**
+     * @return The frame time in seconds which was not simulated because of the step limit
+     */
+    double getDroppedTime() const {
+        return droppedTime;
+    }
+
+private:
+    std::shared_ptr<EntityScene> scene;
+    RenderState renderState;
+
+    SystemRuntime frameRuntime;
+    SystemRuntime simulationRuntime;
+    SystemRuntime renderRuntime;
+
+    TransformInterpolator interpolator;
+
+    DeltaTime step;
+    int maxSteps;
+
+    DeltaTime accumulator = 0;
+    float alpha = 0;
+
+    std::shared_ptr<Task> simulationTask;
+    std::exception_ptr simulationException;
+
+    unsigned long long totalSteps = 0;
+    double droppedTime = 0;
+};
+
+#endif //FOXTROT_FIXEDSTEPRUNTIME_HPP
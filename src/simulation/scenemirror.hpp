@@ -0,0 +1,199 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_SCENEMIRROR_HPP
+#define FOXTROT_SCENEMIRROR_HPP
+
+#include <map>
+#include <vector>
+#include <bitset>
+
+#include "xng/xng.hpp"
+
+#include "ecs/componentversions.hpp"
+
+using namespace xng;
+
+/**
+ * A copy of the components listed in the template arguments of a scene, kept in a separate scene.
+ *
+ * Entities are recreated in the mirror scene with the same names so that the parent references of the
+ * transform components resolve in the mirror. Entities without any of the listed components are not mirrored.
+ *
+ * While attached to the source scene the first copy mirrors the whole scene, afterwards only the entities in the
+ * change log since the last copy (components created, updated or destroyed, entities destroyed or renamed) are visited,
+ * so the render systems see no update for unchanged components.
+ *
+ * @tparam Components The component types to mirror
+ */
+template<typename... Components>
+class SceneMirror {
+public:
+    SceneMirror()
+            : scene(std::make_shared<EntityScene>()) {}
+
+    /**
+     * Track the changes of the source scene so that copy only visits changed entities.
+     */
+    void attach(EntityScene &source) {
+        versions.attach(source);
+        synced = false;
+    }
+
+    void detach() {
+        versions.detach();
+        synced = false;
+    }
+
+    /**
+     * Update the mirror scene to match the source scene.
+     *
+     * The source scene must not be modified concurrently.
+     */
+    void copy(const EntityScene &source) {
+        auto version = versions.getVersion();
+
+        if (!synced) {
+            clear();
+            (copyPool<Components>(source), ...);
+            synced = versions.isAttached();
+        } else {
+            versions.forEachDestroyed(copiedVersion, [this](const EntityHandle &entity) {
+                erase(entity);
+            });
+
+            versions.forEachRenamed(copiedVersion, [this, &source](const EntityHandle &entity) {
+                auto it = mirrored.find(entity);
+                if (it != mirrored.end() && it->second.name != source.getEntityName(entity)) {
+                    // Children in the mirror must resolve the new name
+                    erase(entity);
+                    (copyComponent<Components>(source, entity), ...);
+                }
+            });
+
+            (copyChanged<Components>(source), ...);
+
+            for (auto &entity: emptied) {
+                auto it = mirrored.find(entity);
+                if (it != mirrored.end() && it->second.components.none()) {
+                    erase(entity);
+                }
+            }
+            emptied.clear();
+        }
+
+        versions.discardEntityLog(version);
+        copiedVersion = version;
+    }
+
+    void clear() {
+        for (auto &pair: mirrored) {
+            scene->destroy(pair.second.handle);
+        }
+        mirrored.clear();
+        synced = false;
+    }
+
+    const std::shared_ptr<EntityScene> &getScene() const {
+        return scene;
+    }
+
+private:
+    struct Entry {
+        EntityHandle handle; // The handle in the mirror scene
+        std::string name;
+        std::bitset<sizeof...(Components)> components; // The components present in the mirror scene
+    };
+
+    template<typename T>
+    static constexpr size_t indexOf() {
+        size_t ret = 0;
+        size_t i = 0;
+        ((std::is_same_v<T, Components> ? ret = i : 0, i++), ...);
+        return ret;
+    }
+
+    typename std::map<EntityHandle, Entry>::iterator getEntry(const EntityScene &source, const EntityHandle &entity) {
+        auto it = mirrored.find(entity);
+        if (it == mirrored.end()) {
+            auto name = source.getEntityName(entity);
+            auto ent = name.empty() ? scene->createEntity() : scene->createEntity(name);
+            it = mirrored.emplace(entity, Entry{ent.getHandle(), std::move(name), {}}).first;
+        }
+        return it;
+    }
+
+    void erase(const EntityHandle &entity) {
+        auto it = mirrored.find(entity);
+        if (it != mirrored.end()) {
+            scene->destroy(it->second.handle);
+            mirrored.erase(it);
+        }
+    }
+
+    template<typename T>
+    void assign(Entry &entry, const T &component) {
+        if (entry.components.test(indexOf<T>())) {
+            scene->updateComponent(entry.handle, component);
+        } else {
+            scene->createComponent(entry.handle, component);
+            entry.components.set(indexOf<T>());
+        }
+    }
+
+    template<typename T>
+    void copyPool(const EntityScene &source) {
+        for (auto &pair: source.getPool<T>()) {
+            assign(getEntry(source, pair.first)->second, pair.second);
+        }
+    }
+
+    template<typename T>
+    void copyChanged(const EntityScene &source) {
+        versions.template forEachChanged<T>(copiedVersion, [this, &source](const EntityHandle &entity) {
+            copyComponent<T>(source, entity);
+        });
+    }
+
+    template<typename T>
+    void copyComponent(const EntityScene &source, const EntityHandle &entity) {
+        auto &pool = source.getPool<T>();
+        auto component = pool.find(entity);
+        if (component != pool.end()) {
+            assign(getEntry(source, entity)->second, component->second);
+            return;
+        }
+        auto it = mirrored.find(entity);
+        if (it != mirrored.end() && it->second.components.test(indexOf<T>())) {
+            scene->destroyComponent<T>(it->second.handle);
+            it->second.components.reset(indexOf<T>());
+            emptied.emplace_back(entity);
+        }
+    }
+
+    std::shared_ptr<EntityScene> scene;
+    std::map<EntityHandle, Entry> mirrored; // The mirrored entities by their handle in the source scene
+    std::vector<EntityHandle> emptied; // The entities which lost a mirrored component during a copy
+
+    ComponentVersions<Components...> versions{true}; // The change log of the source scene
+    uint64_t copiedVersion = 0;
+    bool synced = false;
+};
+
+#endif //FOXTROT_SCENEMIRROR_HPP
@@ -0,0 +1,95 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_TRANSFORMINTERPOLATOR_HPP
+#define FOXTROT_TRANSFORMINTERPOLATOR_HPP
+
+#include <map>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * Interpolates the positions of the moving rigid bodies between the last two simulation steps.
+ *
+ * The interpolated positions are written into the scene for the systems presenting it only,
+ * restore() writes back the simulated positions before the next simulation step.
+ */
+class TransformInterpolator {
+public:
+    /**
+     * Store the positions of the moving bodies as the previous state, called before each simulation step.
+     */
+    void capture(const EntityScene &scene) {
+        previous.clear();
+        for (auto &pair: scene.getPool<RigidBodyComponent>()) {
+            if (pair.second.type == RigidBody::STATIC
+                || !scene.checkComponent<TransformComponent>(pair.first))
+                continue;
+            previous[pair.first] = scene.getComponent<TransformComponent>(pair.first).transform.getPosition();
+        }
+    }
+
+    /**
+     * Move the bodies to the position between the previous and the current state.
+     *
+     * Bodies created by the last step have no previous state and stay at their current position.
+     *
+     * @param alpha The fraction of a step between the previous (0) and the current (1) state
+     */
+    void apply(EntityScene &scene, float alpha) {
+        current.clear();
+        for (auto &pair: previous) {
+            // The entity was destroyed during the last step
+            if (!scene.checkComponent<TransformComponent>(pair.first))
+                continue;
+            auto comp = scene.getComponent<TransformComponent>(pair.first);
+            auto position = comp.transform.getPosition();
+            current[pair.first] = position;
+            comp.transform.setPosition(pair.second + (position - pair.second) * alpha);
+            scene.updateComponent(pair.first, comp);
+        }
+    }
+
+    /**
+     * Write back the simulated positions replaced by apply().
+     */
+    void restore(EntityScene &scene) {
+        for (auto &pair: current) {
+            if (!scene.checkComponent<TransformComponent>(pair.first))
+                continue;
+            auto comp = scene.getComponent<TransformComponent>(pair.first);
+            comp.transform.setPosition(pair.second);
+            scene.updateComponent(pair.first, comp);
+        }
+        current.clear();
+    }
+
+    void clear() {
+        previous.clear();
+        current.clear();
+    }
+
+private:
+    std::map<EntityHandle, Vec3f> previous; // The positions before the last simulation step
+    std::map<EntityHandle, Vec3f> current; // The simulated positions while the interpolated ones are applied
+};
+
+#endif //FOXTROT_TRANSFORMINTERPOLATOR_HPP
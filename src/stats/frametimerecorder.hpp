@@ -0,0 +1,162 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_FRAMETIMERECORDER_HPP
+#define FOXTROT_FRAMETIMERECORDER_HPP
+
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <filesystem>
+
+#include "stats/histogram.hpp"
+
+/**
+ * Records the frame, simulation step and render durations in microseconds.
+ *
+ * Each channel keeps a histogram of all samples since the last reset and a rolling histogram of the recent samples,
+ * the rolling histogram is split into slices of which the oldest is discarded by update().
+ * Recording is lock free and may be done from any thread.
+ */
+class FrameTimeRecorder {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Channel {
+        FRAME, // The interval between frames
+        SIMULATION, // The duration of one simulation step
+        RENDER, // The duration of the render pipeline
+        CHANNEL_COUNT
+    };
+
+    static constexpr const char *CHANNEL_NAMES[CHANNEL_COUNT] = {"frame", "simulation", "render"};
+
+    static constexpr size_t SLICES = 4;
+
+    struct Summary {
+        uint64_t count = 0;
+        double p50 = 0; // Milliseconds
+        double p95 = 0;
+        double p99 = 0;
+        double p999 = 0;
+        double max = 0;
+    };
+
+    static FrameTimeRecorder &getDefaultRecorder() {
+        static FrameTimeRecorder recorder;
+        return recorder;
+    }
+
+    void record(Channel channel, Clock::duration duration) {
+        auto value = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        auto &data = *channels.at(channel);
+        auto micros = static_cast<uint64_t>(std::max<decltype(value)>(0, value));
+        data.total.record(micros);
+        data.slices.at(data.currentSlice.load(std::memory_order_relaxed)).record(micros);
+    }
+
+    /**
+     * Discard the oldest slice of the rolling histograms once per slice duration, called once per frame.
+     *
+     * @param window The duration covered by the rolling histograms
+     */
+    void update(Clock::duration window) {
+        auto now = Clock::now();
+        if (now - sliceStart < window / SLICES)
+            return;
+        sliceStart = now;
+        for (auto &data: channels) {
+            auto next = (data->currentSlice.load(std::memory_order_relaxed) + 1) % SLICES;
+            data->slices.at(next).clear();
+            data->currentSlice.store(next, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @param rolling If true only the recent samples are summarized, otherwise all samples since the last reset
+     */
+    Summary getSummary(Channel channel, bool rolling) const {
+        auto &data = *channels.at(channel);
+        if (!rolling)
+            return summarize(data.total);
+        auto merged = std::make_unique<Histogram>();
+        for (auto &slice: data.slices) {
+            slice.addTo(*merged);
+        }
+        return summarize(*merged);
+    }
+
+    void reset() {
+        for (auto &data: channels) {
+            data->total.clear();
+            for (auto &slice: data->slices) {
+                slice.clear();
+            }
+        }
+    }
+
+    /**
+     * Write the non empty buckets of the histograms of all samples since the last reset.
+     */
+    void writeCsv(const std::filesystem::path &file) const {
+        std::ofstream stream(file);
+        stream << "channel,lower_us,upper_us,count\n";
+        for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            auto &histogram = channels.at(channel)->total;
+            for (size_t i = 0; i < Histogram::BUCKET_COUNT; i++) {
+                auto count = histogram.getBucketCount(i);
+                if (count > 0) {
+                    stream << CHANNEL_NAMES[channel] << ","
+                           << Histogram::getLowerBound(i) << ","
+                           << Histogram::getUpperBound(i) << ","
+                           << count << "\n";
+                }
+            }
+        }
+    }
+
+private:
+    struct ChannelData {
+        Histogram total;
+        std::array<Histogram, SLICES> slices;
+        std::atomic<size_t> currentSlice = 0;
+    };
+
+    FrameTimeRecorder() {
+        for (auto &data: channels) {
+            data = std::make_unique<ChannelData>();
+        }
+    }
+
+    static Summary summarize(const Histogram &histogram) {
+        Summary ret;
+        ret.count = histogram.getCount();
+        ret.p50 = static_cast<double>(histogram.getQuantile(0.5)) / 1000;
+        ret.p95 = static_cast<double>(histogram.getQuantile(0.95)) / 1000;
+        ret.p99 = static_cast<double>(histogram.getQuantile(0.99)) / 1000;
+        ret.p999 = static_cast<double>(histogram.getQuantile(0.999)) / 1000;
+        ret.max = static_cast<double>(histogram.getMax()) / 1000;
+        return ret;
+    }
+
+    std::array<std::unique_ptr<ChannelData>, CHANNEL_COUNT> channels;
+    Clock::time_point sliceStart = Clock::now();
+};
+
+#endif //FOXTROT_FRAMETIMERECORDER_HPP
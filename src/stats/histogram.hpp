@@ -0,0 +1,140 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_HISTOGRAM_HPP
+#define FOXTROT_HISTOGRAM_HPP
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+/**
+ * A log-linear histogram of integer values with a relative bucket width below 1/64 (1.6%).
+ *
+ * Values below 64 are counted exactly, larger values in 64 buckets per power of two similar to HdrHistogram.
+ * Recording is lock free and may be done concurrently from multiple threads,
+ * reads concurrent to recording see a recent but not necessarily consistent state.
+ */
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 6;
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_MAGNITUDE = 36; // Values are clamped below 2^36
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (MAX_MAGNITUDE - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    Histogram() = default;
+
+    Histogram(const Histogram &other) = delete;
+
+    Histogram &operator=(const Histogram &other) = delete;
+
+    void record(uint64_t value) {
+        value = std::min(value, (uint64_t(1) << MAX_MAGNITUDE) - 1);
+        buckets.at(getIndex(value)).fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        auto currentMax = max.load(std::memory_order_relaxed);
+        while (value > currentMax && !max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * Add the counts of this histogram to the target, the target must not be recorded to concurrently.
+     */
+    void addTo(Histogram &target) const {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            auto value = buckets.at(i).load(std::memory_order_relaxed);
+            if (value > 0)
+                target.buckets.at(i).fetch_add(value, std::memory_order_relaxed);
+        }
+        target.count.fetch_add(count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        target.max.store(std::max(target.max.load(std::memory_order_relaxed), max.load(std::memory_order_relaxed)),
+                         std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (auto &bucket: buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getMax() const {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getBucketCount(size_t index) const {
+        return buckets.at(index).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @param quantile The quantile in the range [0, 1]
+     * @return The highest value equivalent to the value at the quantile, 0 if the histogram is empty
+     */
+    uint64_t getQuantile(double quantile) const {
+        auto total = getCount();
+        if (total == 0)
+            return 0;
+        auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total))));
+        uint64_t accumulated = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            accumulated += buckets.at(i).load(std::memory_order_relaxed);
+            if (accumulated >= target)
+                return std::min(getUpperBound(i), getMax());
+        }
+        return getMax();
+    }
+
+    static size_t getIndex(uint64_t value) {
+        if (value < SUB_BUCKETS)
+            return value;
+        auto magnitude = std::bit_width(value) - 1;
+        auto shift = magnitude - SUB_BUCKET_BITS;
+        auto subBucket = (value >> shift) - SUB_BUCKETS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + subBucket;
+    }
+
+    static uint64_t getLowerBound(size_t index) {
+        if (index < SUB_BUCKETS)
+            return index;
+        auto shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        auto subBucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return (SUB_BUCKETS + subBucket) << shift;
+    }
+
+    static uint64_t getUpperBound(size_t index) {
+        if (index < SUB_BUCKETS)
+            return index;
+        auto shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        return getLowerBound(index) + (uint64_t(1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint32_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> max = 0;
+};
+
+#endif //FOXTROT_HISTOGRAM_HPP
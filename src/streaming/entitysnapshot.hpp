@@ -0,0 +1,178 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_ENTITYSNAPSHOT_HPP
+#define FOXTROT_ENTITYSNAPSHOT_HPP
+
+#include <optional>
+#include <tuple>
+#include <array>
+#include <typeindex>
+#include <stdexcept>
+
+#include "xng/xng.hpp"
+
+#include "ecs/view.hpp"
+
+using namespace xng;
+
+/**
+ * A copy of an entity which is not part of a scene.
+ *
+ * The snapshot stores the components listed in the template arguments, other components of the entity are not captured.
+ * Capturing fails instead of dropping a component if the entity has one of the given uncaptured component types.
+ * When unloaded the components are kept in serialized form so that the referenced resources can be released.
+ *
+ * @tparam Components The component types to capture
+ */
+template<typename... Components>
+class EntitySnapshot {
+public:
+    template<typename T>
+    static constexpr bool captures = (std::is_same_v<T, Components> || ...);
+
+    static bool capturesType(const std::type_index &type) {
+        return ((type == typeid(Components)) || ...);
+    }
+
+    /**
+     * @return True if the entity has none of the Uncaptured components
+     */
+    template<typename... Uncaptured>
+    static bool canCapture(const EntityScene &scene, const EntityHandle &entity, Exclude<Uncaptured...>) {
+        static_assert(!(captures<Uncaptured> || ...), "A captured component is listed as uncaptured");
+        return !(scene.template checkComponent<Uncaptured>(entity) || ...);
+    }
+
+    /**
+     * Capture the entity, throws if the entity has one of the Uncaptured components which would be dropped.
+     */
+    template<typename... Uncaptured>
+    static EntitySnapshot capture(const EntityScene &scene,
+                                  const EntityHandle &entity,
+                                  Exclude<Uncaptured...> uncaptured) {
+        if (!canCapture(scene, entity, uncaptured))
+            throw std::runtime_error("Entity " + scene.getEntityName(entity)
+                                     + " has a component which is not captured by the snapshot");
+        EntitySnapshot ret;
+        ret.name = scene.getEntityName(entity);
+        (ret.captureComponent<Components>(scene, entity), ...);
+        return ret;
+    }
+
+    /**
+     * Create the entity in the scene, the snapshot must be loaded.
+     *
+     * @param scene
+     * @return The handle of the created entity
+     */
+    EntityHandle restore(EntityScene &scene) const {
+        auto ent = name.empty() ? scene.createEntity() : scene.createEntity(name);
+        (restoreComponent<Components>(ent), ...);
+        return ent.getHandle();
+    }
+
+    /**
+     * Serialize the components and release them, this releases the resource handles referenced by the components.
+     */
+    void unload() {
+        unloadComponents(std::index_sequence_for<Components...>{});
+    }
+
+    /**
+     * Deserialize the components, this acquires the resource handles referenced by the components.
+     */
+    void load() {
+        loadComponents(std::index_sequence_for<Components...>{});
+    }
+
+    bool isLoaded() const {
+        return loaded;
+    }
+
+    const std::string &getName() const {
+        return name;
+    }
+
+    template<typename T>
+    const std::optional<T> &get() const {
+        return std::get<std::optional<T>>(components);
+    }
+
+private:
+    template<typename T>
+    void captureComponent(const EntityScene &scene, const EntityHandle &entity) {
+        if (scene.checkComponent<T>(entity)) {
+            std::get<std::optional<T>>(components) = scene.getComponent<T>(entity);
+        }
+    }
+
+    template<typename T>
+    void restoreComponent(Entity &entity) const {
+        auto &comp = std::get<std::optional<T>>(components);
+        if (comp.has_value()) {
+            entity.createComponent(comp.value());
+        }
+    }
+
+    template<std::size_t... I>
+    void unloadComponents(std::index_sequence<I...>) {
+        if (!loaded)
+            return;
+        (unloadComponent<Components, I>(), ...);
+        loaded = false;
+    }
+
+    template<std::size_t... I>
+    void loadComponents(std::index_sequence<I...>) {
+        if (loaded)
+            return;
+        (loadComponent<Components, I>(), ...);
+        loaded = true;
+    }
+
+    template<typename T, std::size_t I>
+    void unloadComponent() {
+        auto &comp = std::get<std::optional<T>>(components);
+        if (comp.has_value()) {
+            Message message;
+            comp.value() >> message;
+            messages[I] = message;
+            comp.reset();
+        }
+    }
+
+    template<typename T, std::size_t I>
+    void loadComponent() {
+        auto &message = messages[I];
+        if (message.has_value()) {
+            T comp;
+            comp << message.value();
+            std::get<std::optional<T>>(components) = comp;
+            message.reset();
+        }
+    }
+
+    std::string name;
+    bool loaded = true;
+    std::tuple<std::optional<Components>...> components;
+    std::array<std::optional<Message>, sizeof...(Components)> messages;
+};
+
+#endif //FOXTROT_ENTITYSNAPSHOT_HPP
@@ -25,16 +25,30 @@
 #include "components/bulletcomponent.hpp"
 #include "components/healthcomponent.hpp"
 
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/commandbuffer.hpp"
+
 using namespace xng;
 
 class BulletSystem : public System, EventListener {
 public:
-    explicit BulletSystem() {
+    /**
+     * @param commands The bullets are destroyed through the buffer
+     */
+    explicit BulletSystem(CommandBuffer &commands)
+            : commands(commands) {
     }
 
     ~BulletSystem() override {
     }
 
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<ContactEvent>()
+                .writes<BulletComponent, HealthComponent, SpriteAnimationComponent>();
+    }
+
     void start(EntityScene &scene, EventBus &eventBus) override {
         eventBus.addListener(*this);
     }
@@ -83,7 +97,6 @@ public:
 
         contactEvents.clear();
 
-        std::set<EntityHandle> destroyEnts;
         for (auto &pair: scene.getPool<BulletComponent>()) {
             if (pair.second.destroy) {
                 if (pair.second.destroyAnimation.assigned()) {
@@ -93,17 +106,14 @@ public:
                         scene.updateComponent(pair.first, sprite);
                     } else {
                         if (sprite.finished) {
-                            destroyEnts.insert(pair.first);
+                            commands.destroy(pair.first);
                         }
                     }
                 } else {
-                    destroyEnts.insert(pair.first);
+                    commands.destroy(pair.first);
                 }
             }
         }
-        for (auto &ent: destroyEnts) {
-            scene.destroy(ent);
-        }
     }
 
 private:
@@ -113,6 +123,8 @@ private:
         }
     }
 
+    CommandBuffer &commands;
+
     std::vector<ContactEvent> contactEvents;
 };
 
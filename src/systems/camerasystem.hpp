@@ -24,31 +24,74 @@
 
 #include "components/charactercontrollercomponent.hpp"
 
+#include "frontend.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/namedentity.hpp"
+#include "ecs/componentversions.hpp"
+
 using namespace xng;
 
+/**
+ * Moves the camera of the main canvas to the first character, the canvas is only recomputed when the character
+ * transform, the canvas, the viewport or the bounds changed.
+ */
 class CameraSystem : public System {
 public:
-    explicit CameraSystem(RenderTarget &target, Vec2f cameraMin, Vec2f cameraMax)
-            : target(target),
+    explicit CameraSystem(const Frontend &frontend, Vec2f cameraMin, Vec2f cameraMax)
+            : frontend(frontend),
               cameraBoundMin(std::move(cameraMin)),
               cameraBoundMax(std::move(cameraMax)) {}
 
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<CharacterControllerComponent, TransformComponent>()
+                .writes<CanvasComponent>();
+    }
+
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        mainCanvas.attach(scene);
+        versions.attach(scene);
+        dirty = true;
+    }
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        mainCanvas.detach();
+        versions.detach();
+    }
+
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        EntityHandle player;
         Vec3f playerPosition;
-        for (auto &pair: scene.getPool<CharacterControllerComponent>()) {
-            auto &tcomp = scene.getComponent<TransformComponent>(pair.first);
-            playerPosition = tcomp.transform.getPosition();
-            break;
-        }
-
-        std::vector<EntityHandle> ents = {
-                scene.getEntityByName("MainCanvas"),
-        };
+        view<CharacterControllerComponent, TransformComponent>(scene).each(
+                [&](const EntityHandle &entity, const CharacterControllerComponent &, const TransformComponent &tcomp) {
+                    player = entity;
+                    playerPosition = tcomp.transform.getPosition();
+                    return false;
+                });
+
+        auto canvasEnt = mainCanvas.get();
+        if (canvasEnt) {
+            auto viewportSize = frontend.getViewportSize();
+            if (!dirty
+                && player == cameraPlayer
+                && canvasEnt == cameraCanvas
+                && viewportSize == cameraViewportSize
+                && !versions.changedSince<TransformComponent>(player, checkedVersion)
+                && !versions.changedSince<CanvasComponent>(canvasEnt, checkedVersion)) {
+                return;
+            }
+            dirty = false;
+            cameraPlayer = player;
+            cameraCanvas = canvasEnt;
+            cameraViewportSize = viewportSize;
 
-        for (auto &canvasEnt: ents) {
             auto comp = scene.getComponent<CanvasComponent>(canvasEnt);
+            auto previousPosition = comp.cameraPosition;
 
-            auto halfSize = target.getDescription().size.convert<float>() / 2;
+            auto halfSize = viewportSize.convert<float>() / 2;
 
             comp.cameraPosition.x = -playerPosition.x;
             if (comp.cameraPosition.x - halfSize.x < cameraBoundMin.x) {
@@ -66,17 +109,32 @@ public:
             }
             comp.cameraPosition.y -= halfSize.y;
 
-            scene.updateComponent(canvasEnt, comp);
+            if (comp.cameraPosition != previousPosition) {
+                scene.updateComponent(canvasEnt, comp);
+            }
+
+            // Taken after the write so that the own update of the canvas does not count as a change
+            checkedVersion = versions.getVersion();
         }
     }
 
     void setCameraBounds(const Vec2f &boundMin, const Vec2f &boundMax) {
         cameraBoundMin = boundMin;
         cameraBoundMax = boundMax;
+        dirty = true;
     }
 
 private:
-    RenderTarget &target;
+    const Frontend &frontend;
+
+    NamedEntity mainCanvas{"MainCanvas"};
+
+    ComponentVersions<TransformComponent, CanvasComponent> versions;
+    uint64_t checkedVersion = 0;
+    bool dirty = true; // Set on start and when the bounds change
+    EntityHandle cameraPlayer;
+    EntityHandle cameraCanvas;
+    Vec2i cameraViewportSize;
 
     Vec2f cameraBoundMin;
     Vec2f cameraBoundMax;
@@ -29,6 +29,11 @@
 #include "components/playercomponent.hpp"
 #include "components/npccomponent.hpp"
 
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/componentupdates.hpp"
+
 using namespace xng;
 
 class CharacterControllerSystem : public System, public EventListener, public EntityScene::Listener {
@@ -37,6 +42,20 @@ public:
 
     virtual ~CharacterControllerSystem() {}
 
+    // The health is read through the scene listener to detect damage
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<TransformComponent,
+                        RectTransformComponent,
+                        HealthComponent,
+                        InputComponent,
+                        FloorComponent>()
+                .writes<CharacterControllerComponent,
+                        RigidBodyComponent,
+                        SpriteAnimationComponent,
+                        SpriteComponent>();
+    }
+
     void start(EntityScene &scene, EventBus &eventBus) override {
         eventBus.addListener(*this);
         scene.addListener(*this);
@@ -58,16 +77,24 @@ public:
 
         damageEnts.clear();
 
-        std::map<EntityHandle, CharacterControllerComponent> characterUpdates;
-        for (auto &pair: scene.getPool<CharacterControllerComponent>()) {
-            auto &tcomp = scene.getComponent<TransformComponent>(pair.first);
-            auto &rt = scene.getComponent<RectTransformComponent>(pair.first);
-            auto rb = scene.getComponent<RigidBodyComponent>(pair.first);
-            auto anim = scene.getComponent<SpriteAnimationComponent>(pair.first);
-            auto sprite = scene.getComponent<SpriteComponent>(pair.first);
-            auto health = scene.getComponent<HealthComponent>(pair.first);
-            auto input = scene.getComponent<InputComponent>(pair.first);
-            auto character = pair.second;
+        view<CharacterControllerComponent,
+                TransformComponent,
+                RigidBodyComponent,
+                SpriteAnimationComponent,
+                SpriteComponent,
+                HealthComponent,
+                InputComponent>(scene).each([&](const EntityHandle &entity,
+                                                const CharacterControllerComponent &characterComponent,
+                                                const TransformComponent &tcomp,
+                                                const RigidBodyComponent &rbComponent,
+                                                const SpriteAnimationComponent &animComponent,
+                                                const SpriteComponent &spriteComponent,
+                                                const HealthComponent &health,
+                                                const InputComponent &input) {
+            auto rb = rbComponent;
+            auto anim = animComponent;
+            auto sprite = spriteComponent;
+            auto character = characterComponent;
 
             character.isOnFloor = false;
             for (auto &tcPair: rb.touchingColliders) {
@@ -143,16 +170,13 @@ public:
                 character.damageTimer -= deltaTime;
             }
 
-            scene.updateComponent(pair.first, rb);
-            scene.updateComponent(pair.first, anim);
-            scene.updateComponent(pair.first, sprite);
+            updates.update(entity, rb);
+            updates.update(entity, anim);
+            updates.update(entity, sprite);
+            updates.update(entity, character);
+        });
 
-            characterUpdates[pair.first] = character;
-        }
-
-        for (auto &pair: characterUpdates) {
-            scene.updateComponent(pair.first, pair.second);
-        }
+        updates.apply(scene);
     }
 
     void onEvent(const Event &event) override {
@@ -173,6 +197,10 @@ public:
 
 private:
     std::set<EntityHandle> damageEnts;
+    ComponentUpdates<RigidBodyComponent,
+            SpriteAnimationComponent,
+            SpriteComponent,
+            CharacterControllerComponent> updates;
 };
 
 #endif //FOXTROT_CHARACTERCONTROLLERSYSTEM_HPP
@@ -0,0 +1,376 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_CHUNKSTREAMINGSYSTEM_HPP
+#define FOXTROT_CHUNKSTREAMINGSYSTEM_HPP
+
+#include <atomic>
+
+#include "xng/xng.hpp"
+
+#include "streaming/entitysnapshot.hpp"
+
+#include "components/levelcomponents.hpp"
+
+#include "frontend.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/commandbuffer.hpp"
+#include "ecs/namedentity.hpp"
+
+using namespace xng;
+
+/**
+ * Streams the static world entities of a level in spatial chunks around the camera.
+ *
+ * On start the top level entities which are drawn on the streamed canvas are cooked into chunks of chunkSize units.
+ * Chunks near the camera are active (their entities exist in the scene), chunks further away are
+ * loaded (kept as snapshots with their resources resident) and all other chunks are unloaded
+ * (serialized, resources released). Loading and unloading runs on the thread pool,
+ * activating and deactivating a chunk is recorded in the command buffer and applied after the update.
+ *
+ * Characters, players, bullets and backdrops are never streamed, the chunk containing a character is kept active.
+ *
+ * Entities are only streamed if they lie within a single chunk and all their components are captured by the snapshot.
+ * Entities which are destroyed by other systems or receive an uncaptured component while active are no longer streamed.
+ * Rigid bodies and floors always stay in the scene because colliders can reach far beyond the chunk of their
+ * transform and a character must never lose the ground it stands on.
+ */
+class ChunkStreamingSystem : public System, public EntityScene::Listener {
+public:
+    struct Settings {
+        float chunkSize = 2000;
+        int activeRadius = 1; // Chunks within this chebyshev distance of the camera chunk are activated
+        int loadRadius = 2; // Chunks within this distance are loaded in the background
+        int hysteresis = 1; // Additional distance before a chunk is deactivated / unloaded again
+        std::string canvas = "MainCanvas";
+    };
+
+    typedef EntitySnapshot<TransformComponent,
+            RectTransformComponent,
+            SpriteComponent,
+            SpriteAnimationComponent,
+            TextComponent,
+            HealthComponent> Snapshot;
+
+    /**
+     * The components which are not captured by the snapshot, entities with any of them are never streamed.
+     * Every other component type of LevelComponents must be captured, which is checked below.
+     */
+    typedef Exclude<PlayerComponent,
+            InputComponent,
+            BulletComponent,
+            BackdropComponent,
+            CharacterControllerComponent,
+            NpcComponent,
+            MuzzleFlashComponent,
+            FpsComponent,
+            RigidBodyComponent,
+            FloorComponent,
+            CanvasComponent,
+            ButtonComponent,
+            AudioSourceComponent,
+            AudioListenerComponent> Unstreamed;
+
+    template<typename... Ts>
+    static constexpr bool isStreamable(std::tuple<Ts...> *) {
+        return ((Snapshot::captures<Ts> || Unstreamed::contains<Ts>) && ...);
+    }
+
+    typedef std::pair<int, int> ChunkCoord;
+
+    enum ChunkState {
+        CHUNK_UNLOADED,
+        CHUNK_LOADING,
+        CHUNK_LOADED,
+        CHUNK_UNLOADING,
+        CHUNK_ACTIVE,
+    };
+
+    /**
+     * @param commands The entities of the chunks are restored and destroyed through the buffer
+     */
+    ChunkStreamingSystem(const Frontend &frontend, CommandBuffer &commands)
+            : frontend(frontend),
+              commands(commands),
+              canvasEntity(settings.canvas) {}
+
+    ChunkStreamingSystem(const Frontend &frontend, CommandBuffer &commands, Settings settings)
+            : frontend(frontend),
+              commands(commands),
+              settings(std::move(settings)),
+              canvasEntity(this->settings.canvas) {}
+
+    ~ChunkStreamingSystem() override {
+        awaitTasks();
+    }
+
+    static SystemAccess getAccess() {
+        return SystemAccess().reads<CanvasComponent, CharacterControllerComponent, TransformComponent>();
+    }
+
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        canvasEntity.attach(scene);
+        cookChunks(scene);
+        scene.addListener(*this);
+    }
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        scene.removeListener(*this);
+        awaitTasks();
+        chunks.clear();
+        streamed.clear();
+        canvasEntity.detach();
+    }
+
+    void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
+        auto center = getChunkCoord(getCameraCenter(scene, canvasEntity.get()));
+
+        std::set<ChunkCoord> pinned;
+        view<CharacterControllerComponent, TransformComponent>(scene).each(
+                [&](const EntityHandle &entity, const CharacterControllerComponent &, const TransformComponent &tcomp) {
+                    pinned.insert(getChunkCoord(tcomp.transform.getPosition()));
+                });
+
+        for (auto &pair: chunks) {
+            auto &chunk = *pair.second;
+            auto distance = getDistance(pair.first, center);
+            bool isPinned = pinned.find(pair.first) != pinned.end();
+
+            switch (chunk.state) {
+                case CHUNK_UNLOADED:
+                    if (distance <= settings.loadRadius || isPinned) {
+                        startLoad(chunk);
+                    }
+                    break;
+                case CHUNK_LOADING:
+                case CHUNK_UNLOADING:
+                    if (chunk.taskFinished) {
+                        chunk.task->join();
+                        chunk.task = nullptr;
+                        chunk.state = chunk.state == CHUNK_LOADING ? CHUNK_LOADED : CHUNK_UNLOADED;
+                    }
+                    break;
+                case CHUNK_LOADED:
+                    if (distance <= settings.activeRadius || isPinned) {
+                        commands.record([this, coord = pair.first, &chunk](EntityScene &scene) {
+                            activate(coord, chunk, scene);
+                        });
+                    } else if (distance > settings.loadRadius + settings.hysteresis) {
+                        startUnload(chunk);
+                    }
+                    break;
+                case CHUNK_ACTIVE:
+                    if (distance > settings.activeRadius + settings.hysteresis && !isPinned) {
+                        commands.record([this, &chunk](EntityScene &scene) {
+                            deactivate(chunk, scene);
+                        });
+                    }
+                    break;
+            }
+        }
+    }
+
+    const Settings &getSettings() const {
+        return settings;
+    }
+
+    void setSettings(const Settings &value) {
+        settings = value;
+        canvasEntity.setName(settings.canvas);
+    }
+
+    void onEntityDestroy(const EntityHandle &entity) override {
+        unstream(entity);
+    }
+
+    void onComponentCreate(const EntityHandle &entity, const Component &component) override {
+        if (!Snapshot::capturesType(component.getType()))
+            unstream(entity);
+    }
+
+    size_t getChunkCount(ChunkState state) const {
+        size_t ret = 0;
+        for (auto &pair: chunks) {
+            if (pair.second->state == state)
+                ret++;
+        }
+        return ret;
+    }
+
+private:
+    struct Chunk {
+        ChunkState state = CHUNK_ACTIVE;
+        std::set<EntityHandle> entities; // The entities in the scene while active
+        std::vector<Snapshot> snapshots; // The entities while not active
+        std::shared_ptr<Task> task;
+        std::atomic<bool> taskFinished = false;
+    };
+
+    void cookChunks(EntityScene &scene) {
+        std::set<std::string> parents;
+        for (auto &pair: scene.getPool<TransformComponent>()) {
+            if (!pair.second.parent.empty())
+                parents.insert(pair.second.parent);
+        }
+
+        view<TransformComponent, RectTransformComponent>(scene, Unstreamed()).each([&](const EntityHandle &ent,
+                                                                                       const TransformComponent &tcomp,
+                                                                                       const RectTransformComponent &rt) {
+            if (!tcomp.parent.empty()
+                || rt.parent != settings.canvas
+                || parents.find(scene.getEntityName(ent)) != parents.end()) {
+                return;
+            }
+            auto coord = getChunkCoord(tcomp.transform.getPosition());
+            if (!isWithinChunk(coord, tcomp.transform, rt)) {
+                return;
+            }
+            getChunk(coord).entities.insert(ent);
+            streamed[ent] = coord;
+        });
+    }
+
+    void activate(const ChunkCoord &coord, Chunk &chunk, EntityScene &scene) {
+        for (auto &snapshot: chunk.snapshots) {
+            auto ent = snapshot.restore(scene);
+            chunk.entities.insert(ent);
+            streamed[ent] = coord;
+        }
+        chunk.snapshots.clear();
+        chunk.state = CHUNK_ACTIVE;
+    }
+
+    void deactivate(Chunk &chunk, EntityScene &scene) {
+        // Entities destroyed or changed by other systems have been removed from the chunk by the listener
+        for (auto &ent: chunk.entities) {
+            streamed.erase(ent);
+            auto snapshot = Snapshot::capture(scene, ent, Unstreamed());
+            scene.destroy(ent);
+            chunk.snapshots.emplace_back(std::move(snapshot));
+        }
+        chunk.entities.clear();
+        chunk.state = CHUNK_LOADED;
+    }
+
+    /**
+     * Remove an active entity from its chunk, it stays in the scene.
+     */
+    void unstream(const EntityHandle &entity) {
+        auto it = streamed.find(entity);
+        if (it == streamed.end())
+            return;
+        getChunk(it->second).entities.erase(entity);
+        streamed.erase(it);
+    }
+
+    void startLoad(Chunk &chunk) {
+        chunk.state = CHUNK_LOADING;
+        chunk.taskFinished = false;
+        chunk.task = ThreadPool::getPool().addTask([&chunk]() {
+            for (auto &snapshot: chunk.snapshots) {
+                snapshot.load();
+                prefetch(snapshot);
+            }
+            chunk.taskFinished = true;
+        });
+    }
+
+    void startUnload(Chunk &chunk) {
+        chunk.state = CHUNK_UNLOADING;
+        chunk.taskFinished = false;
+        chunk.task = ThreadPool::getPool().addTask([&chunk]() {
+            for (auto &snapshot: chunk.snapshots) {
+                snapshot.unload();
+            }
+            chunk.taskFinished = true;
+        });
+    }
+
+    static void prefetch(const Snapshot &snapshot) {
+        auto &sprite = snapshot.get<SpriteComponent>();
+        if (sprite.has_value() && sprite->sprite.assigned())
+            sprite->sprite.get();
+        auto &anim = snapshot.get<SpriteAnimationComponent>();
+        if (anim.has_value() && anim->animation.assigned())
+            anim->animation.get();
+    }
+
+    void awaitTasks() {
+        for (auto &pair: chunks) {
+            if (pair.second->task)
+                pair.second->task->join();
+        }
+    }
+
+    Chunk &getChunk(const ChunkCoord &coord) {
+        auto it = chunks.find(coord);
+        if (it == chunks.end()) {
+            // Chunks are referenced by the load tasks and therefore not stored by value
+            it = chunks.emplace(coord, std::make_unique<Chunk>()).first;
+        }
+        return *it->second;
+    }
+
+    Vec3f getCameraCenter(EntityScene &scene, const EntityHandle &canvasEnt) const {
+        auto &canvas = scene.getComponent<CanvasComponent>(canvasEnt);
+        auto halfSize = frontend.getViewportSize().convert<float>() / 2;
+        // The canvas camera position is the negated world position of the top left corner of the view
+        return {-(canvas.cameraPosition.x + halfSize.x), -(canvas.cameraPosition.y + halfSize.y), 0};
+    }
+
+    ChunkCoord getChunkCoord(const Vec3f &position) const {
+        return {static_cast<int>(std::floor(position.x / settings.chunkSize)),
+                static_cast<int>(std::floor(position.y / settings.chunkSize))};
+    }
+
+    /**
+     * Check whether the rect of the entity lies in the chunk for any rotation and alignment of the rect,
+     * by testing a circle around the transform position with the scaled diagonal of the rect as radius.
+     */
+    bool isWithinChunk(const ChunkCoord &coord, const Transform &transform, const RectTransformComponent &rt) const {
+        auto &size = rt.rectTransform.size;
+        auto scale = transform.getScale();
+        // Scales below one are not trusted to shrink the rect, the bound stays conservative
+        auto radius = std::sqrt(size.x * size.x + size.y * size.y)
+                      * std::max({1.0f, std::abs(scale.x), std::abs(scale.y)});
+        auto position = transform.getPosition();
+        return getChunkCoord(Vec3f(position.x - radius, position.y - radius, 0)) == coord
+               && getChunkCoord(Vec3f(position.x + radius, position.y + radius, 0)) == coord;
+    }
+
+    static int getDistance(const ChunkCoord &a, const ChunkCoord &b) {
+        return std::max(std::abs(a.first - b.first), std::abs(a.second - b.second));
+    }
+
+    const Frontend &frontend;
+    CommandBuffer &commands;
+    Settings settings;
+    NamedEntity canvasEntity;
+
+    std::map<ChunkCoord, std::unique_ptr<Chunk>> chunks;
+    std::map<EntityHandle, ChunkCoord> streamed; // The chunk of each active streamed entity
+};
+
+static_assert(ChunkStreamingSystem::isStreamable(static_cast<LevelComponents *>(nullptr)),
+              "Each component of LevelComponents must be captured by the snapshot or listed as unstreamed");
+
+#endif //FOXTROT_CHUNKSTREAMINGSYSTEM_HPP
@@ -22,12 +22,23 @@
 
 #include "xng/xng.hpp"
 
+#include "resource/assets.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
 using namespace xng;
 
 class CursorSystem : public System {
 public:
     CursorSystem(Input &input) : input(input) {}
 
+    // The window input is written to hide the mouse cursor
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<PlayerComponent, InputComponent>()
+                .writes<RectTransformComponent, Input>();
+    }
+
     void start(EntityScene &scene, EventBus &eventBus) override {
         Entity ent = scene.createEntity();
         auto rt = RectTransformComponent();
@@ -36,7 +47,7 @@ public:
         rt.parent = "OverlayCanvas";
         ent.createComponent(rt);
         auto sprite = SpriteComponent();
-        sprite.sprite = ResourceHandle<Sprite>(Uri("file://sprites/crosshair.json/target"));
+        sprite.sprite = ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_CROSSHAIR_JSON_TARGET));
         //sprite.layer = 10;
         ent.createComponent(sprite);
         crossHairEntity = ent;
@@ -24,9 +24,22 @@
 
 #include "xng/xng.hpp"
 
+#include "resource/assets.hpp"
+
 #include "components/playercomponent.hpp"
 #include "components/fpscomponent.hpp"
 
+#include "stats/frametimerecorder.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/componentupdates.hpp"
+#include "ecs/namedentity.hpp"
+#include "ecs/componentversions.hpp"
+
+#include "cvars.hpp"
+
 using namespace xng;
 
 class GameGuiSystem : public System, public EventListener {
@@ -34,8 +47,20 @@ public:
     explicit GameGuiSystem(Input &input)
             : input(input) {}
 
+    // The window input is written to hide the mouse cursor
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<InputComponent, HealthComponent, PlayerComponent, FpsComponent>()
+                .writes<TextComponent, Input>();
+    }
+
     void start(EntityScene &scene, EventBus &eventBus) override {
         eventBus.addListener(*this);
+        ammoGui.attach(scene);
+        healthGui.attach(scene);
+        versions.attach(scene);
+        checkedVersion = 0;
+        displayedAmmo = {};
 
         toolbarEntity = scene.createEntity();
         auto rt = RectTransformComponent();
@@ -46,7 +71,7 @@ public:
         rt.rectTransform.alignment = xng::RectTransform::RECT_ALIGN_CENTER_TOP;
         toolbarEntity.createComponent(rt);
         auto sprite = SpriteComponent();
-        sprite.sprite = ResourceHandle<Sprite>(Uri("sprites/toolbar.json"));
+        sprite.sprite = ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_TOOLBAR_JSON));
         toolbarEntity.createComponent(sprite);
 
         createSlotEntities(scene);
@@ -54,6 +79,9 @@ public:
 
     void stop(EntityScene &scene, EventBus &eventBus) override {
         eventBus.removeListener(*this);
+        ammoGui.detach();
+        healthGui.detach();
+        versions.detach();
         scene.destroyEntity(toolbarEntity);
         for (auto &ent: slotEntities) {
             scene.destroyEntity(ent);
@@ -62,15 +90,12 @@ public:
     }
 
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
-        for (auto &pair: scene.getPool<InputComponent>()) {
-            auto &health = scene.getComponent<HealthComponent>(pair.first);
-            if (health.health > 0 && pair.second.aim) {
-                input.setMouseCursorHidden(true);
-            } else {
-                input.setMouseCursorHidden(false);
-            }
-            break;
-        }
+        view<InputComponent, HealthComponent>(scene).each([&](const EntityHandle &entity,
+                                                               const InputComponent &inputComponent,
+                                                               const HealthComponent &health) {
+            input.setMouseCursorHidden(health.health > 0 && inputComponent.aim);
+            return false;
+        });
         Entity player;
         for (auto &pair: scene.getPool<PlayerComponent>()) {
             player = Entity(pair.first, scene);
@@ -81,41 +106,77 @@ public:
             auto &inv = plc.player.getInventory();
             auto &acc = plc.player.getAccount();
 
-            auto ammoGui = scene.getEntity("AmmoGUI");
-            auto ammoText = ammoGui.getComponent<TextComponent>();
-            ammoText.text = std::to_string(plc.player.getWeapon().getClip()) + " / " +
-                            std::to_string(plc.player.getWeapon().getClipSize());
-            if (plc.player.getWeapon().getReloadTimer() > 0) {
-                ammoText.textColor = ColorRGBA::yellow();
-            } else {
-                ammoText.textColor = ColorRGBA::gray();
+            // The player component changes every frame so the displayed ammo values are compared instead
+            auto ammoEnt = Entity(ammoGui.get(), scene);
+            AmmoState ammo{plc.player.getWeapon().getClip(),
+                           plc.player.getWeapon().getClipSize(),
+                           plc.player.getWeapon().getReloadTimer() > 0};
+            if (ammo != displayedAmmo
+                || versions.changedSince<TextComponent>(ammoEnt.getHandle(), checkedVersion)) {
+                displayedAmmo = ammo;
+                auto ammoText = ammoEnt.getComponent<TextComponent>();
+                ammoText.text = std::to_string(ammo.clip) + " / " + std::to_string(ammo.clipSize);
+                if (ammo.reloading) {
+                    ammoText.textColor = ColorRGBA::yellow();
+                } else {
+                    ammoText.textColor = ColorRGBA::gray();
+                }
+                ammoEnt.updateComponent(ammoText);
             }
-            ammoGui.updateComponent(ammoText);
 
-            auto &health = player.getComponent<HealthComponent>();
+            auto healthEnt = Entity(healthGui.get(), scene);
+            if (versions.changedSince<HealthComponent>(player.getHandle(), checkedVersion)
+                || versions.changedSince<TextComponent>(healthEnt.getHandle(), checkedVersion)) {
+                auto &health = player.getComponent<HealthComponent>();
+
+                auto healthText = healthEnt.getComponent<TextComponent>();
 
-            auto healthGui = scene.getEntity("HealthGUI");
-            auto healthText = healthGui.getComponent<TextComponent>();
+                healthText.textColor = ColorRGBA::red();
 
-            healthText.textColor = ColorRGBA::red();
+                healthText.text = std::to_string(floorf(health.health * 100) / 100);
 
-            healthText.text = std::to_string(floorf(health.health * 100) / 100);
+                healthText.text.erase(healthText.text.find_last_not_of('0') + 1, std::string::npos);
+                healthText.text.erase(healthText.text.find_last_not_of('.') + 1, std::string::npos);
 
-            healthText.text.erase(healthText.text.find_last_not_of('0') + 1, std::string::npos);
-            healthText.text.erase(healthText.text.find_last_not_of('.') + 1, std::string::npos);
+                healthEnt.updateComponent(healthText);
+            }
 
-            healthGui.updateComponent(healthText);
+            // Taken after the writes so that the own updates of the texts do not count as changes
+            checkedVersion = versions.getVersion();
         }
 
-        float fps = deltaTime > 0 ? std::round(1.0f / deltaTime) : 0;
-        std::stringstream stream;
-        stream << std::fixed << std::setprecision(0) << fps;
-        std::string fpsStr = stream.str();
-        for (auto &pair: scene.getPool<FpsComponent>()) {
-            auto text = scene.getComponent<TextComponent>(pair.first);
-            text.text = fpsStr;
-            scene.updateComponent(pair.first, text);
+        std::string fpsStr;
+        if (CVars::statsOverlay.get()) {
+            // Computing the percentiles walks the histograms so the overlay is refreshed a few times per second
+            overlayTimer -= deltaTime;
+            if (overlayTimer > 0)
+                return;
+            overlayTimer = OVERLAY_INTERVAL;
+            auto frame = FrameTimeRecorder::getDefaultRecorder().getSummary(FrameTimeRecorder::FRAME, true);
+            std::stringstream stream;
+            stream << std::fixed << std::setprecision(1)
+                   << "p50 " << frame.p50
+                   << " p95 " << frame.p95
+                   << " p99 " << frame.p99
+                   << " p99.9 " << frame.p999
+                   << " max " << frame.max << " ms";
+            fpsStr = stream.str();
+        } else {
+            float fps = deltaTime > 0 ? std::round(1.0f / deltaTime) : 0;
+            std::stringstream stream;
+            stream << std::fixed << std::setprecision(0) << fps;
+            fpsStr = stream.str();
         }
+        view<FpsComponent, TextComponent>(scene).each([&](const EntityHandle &entity,
+                                                           const FpsComponent &,
+                                                           const TextComponent &textComponent) {
+            if (textComponent.text == fpsStr)
+                return;
+            auto text = textComponent;
+            text.text = fpsStr;
+            updates.update(entity, text);
+        });
+        updates.apply(scene);
     }
 
     void onEvent(const Event &event) override {
@@ -136,9 +197,9 @@ private:
             ent.createComponent(rt);
             ent.createComponent(SpriteComponent());
             auto btn = ButtonComponent();
-            btn.sprite = ResourceHandle<Sprite>(Uri("sprites/celltile.json/idle"));
-            btn.spriteHover = ResourceHandle<Sprite>(Uri("sprites/celltile.json/hover"));
-            btn.spritePressed = ResourceHandle<Sprite>(Uri("sprites/celltile.json/press"));
+            btn.sprite = ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_CELLTILE_JSON_IDLE));
+            btn.spriteHover = ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_CELLTILE_JSON_HOVER));
+            btn.spritePressed = ResourceHandle<Sprite>(Assets::uri(ASSET_SPRITES_CELLTILE_JSON_PRESS));
             btn.id = TOOLBAR_BUTTON + std::to_string(i);
             ent.createComponent(btn);
         }
@@ -157,8 +218,31 @@ private:
         return {};
     }
 
+    static constexpr float OVERLAY_INTERVAL = 0.25f;
+
     Input &input;
 
+    float overlayTimer = 0;
+
+    struct AmmoState {
+        int clip = -1;
+        int clipSize = -1;
+        bool reloading = false;
+
+        bool operator!=(const AmmoState &other) const {
+            return clip != other.clip || clipSize != other.clipSize || reloading != other.reloading;
+        }
+    };
+
+    ComponentUpdates<TextComponent> updates;
+
+    ComponentVersions<HealthComponent, TextComponent> versions;
+    uint64_t checkedVersion = 0;
+    AmmoState displayedAmmo;
+
+    NamedEntity ammoGui{"AmmoGUI"};
+    NamedEntity healthGui{"HealthGUI"};
+
     Entity toolbarEntity;
     std::vector<Entity> slotEntities;
 
@@ -25,6 +25,8 @@
 #include "components/inputcomponent.hpp"
 #include "components/healthcomponent.hpp"
 
+#include "scheduler/systemaccess.hpp"
+
 using namespace xng;
 
 class InputSystem : public System {
@@ -32,6 +34,10 @@ public:
     explicit InputSystem(Input &input)
             : input(input) {}
 
+    static SystemAccess getAccess() {
+        return SystemAccess().reads<Input>().writes<InputComponent>();
+    }
+
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
         std::map<EntityHandle, InputComponent> updates;
         for (auto &pair: scene.getPool<InputComponent>()) {
@@ -83,7 +89,8 @@ public:
 
             comp.aimPosition = mouse.position.convert<float>();
 
-            comp.fire = mouse.getButtonDown(xng::LEFT) || kb.getKeyDown(xng::KEY_SPACE);
+            // Latched until a simulation step consumes it so that a press is not lost in frames without a step
+            comp.fire = comp.fire || mouse.getButtonDown(xng::LEFT) || kb.getKeyDown(xng::KEY_SPACE);
             comp.fireHold = mouse.getButton(xng::LEFT) || kb.getKey(xng::KEY_SPACE);
             comp.reload = kb.getKey(xng::KEY_R);
 
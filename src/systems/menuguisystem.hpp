@@ -22,6 +22,8 @@
 
 #include "xng/xng.hpp"
 
+#include "profile/profiler.hpp"
+
 using namespace xng;
 
 class MenuGuiSystem : public System, public EventListener {
@@ -39,6 +41,7 @@ public:
 
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
         for (auto &ev : events){
+            ProfileZone zone("Dispatch LoadLevelEvent", "event");
             eventBus.invoke(ev);
         }
         events.clear();
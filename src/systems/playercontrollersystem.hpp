@@ -24,19 +24,49 @@
 
 #include "xng/xng.hpp"
 
+#include "resource/assets.hpp"
+
 #include "components/muzzleflashcomponent.hpp"
 #include "components/charactercontrollercomponent.hpp"
 
 #include "bullets/smallbullet.hpp"
 
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/componentupdates.hpp"
+#include "ecs/commandbuffer.hpp"
+#include "ecs/namedentity.hpp"
+
 using namespace xng;
 
 class PlayerControllerSystem : public System {
 public:
-    PlayerControllerSystem()
-            : rng(dev()) {}
+    /**
+     * @param commands The weapon, muzzle flash, sound and bullet entities are created and destroyed through the buffer
+     */
+    explicit PlayerControllerSystem(CommandBuffer &commands)
+            : commands(commands),
+              rng(dev()) {}
+
+    static SystemAccess getAccess() {
+        return SystemAccess()
+                .reads<RigidBodyComponent,
+                        HealthComponent,
+                        CanvasComponent,
+                        MuzzleFlashComponent>()
+                .writes<PlayerComponent,
+                        CharacterControllerComponent,
+                        InputComponent,
+                        SpriteAnimationComponent,
+                        SpriteComponent,
+                        TransformComponent,
+                        RectTransformComponent>();
+    }
 
-    void start(EntityScene &scene, EventBus &eventBus) override {}
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        mainCanvas.attach(scene);
+    }
 
     void stop(EntityScene &scene, EventBus &eventBus) override {
         for (auto &ent: weaponEntities) {
@@ -49,40 +79,44 @@ public:
         }
         weaponEntities.clear();
         muzzleFlashEntities.clear();
+        mainCanvas.detach();
     }
 
 private:
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
-        std::set<EntityHandle> delHandles;
-        for (auto &pair: scene.getPool<MuzzleFlashComponent>()) {
-            auto &anim = scene.getComponent<SpriteAnimationComponent>(pair.first);
-            if (anim.finished) {
-                delHandles.insert(pair.first);
-            }
-        }
-        for (auto &ent: delHandles) {
-            scene.destroy(ent);
-        }
-
-        EntityHandle canvasEnt;
-        for (auto &pair: scene.getPool<CanvasComponent>()){
-            canvasEnt = pair.first;
-        }
-
-        std::map<EntityHandle, PlayerComponent> playerUpdates;
-        for (auto &pair: scene.getPool<PlayerComponent>()) {
-            auto &tcomp = scene.getComponent<TransformComponent>(pair.first);
-            auto &rt = scene.getComponent<RectTransformComponent>(pair.first);
-            auto &rb = scene.getComponent<RigidBodyComponent>(pair.first);
-            auto anim = scene.getComponent<SpriteAnimationComponent>(pair.first);
-            auto &sprite = scene.getComponent<SpriteComponent>(pair.first);
-            auto &health = scene.getComponent<HealthComponent>(pair.first);
-            auto character = scene.getComponent<CharacterControllerComponent>(pair.first);
-            auto &input = scene.getComponent<InputComponent>(pair.first);
-            auto player = pair.second;
-
-            if (weaponEntities.find(pair.first) == weaponEntities.end()) {
-                createWeaponEntity(pair.first, scene);
+        view<MuzzleFlashComponent, SpriteAnimationComponent>(scene).each(
+                [&](const EntityHandle &entity, const MuzzleFlashComponent &, const SpriteAnimationComponent &anim) {
+                    if (anim.finished) {
+                        commands.destroy(entity);
+                    }
+                });
+
+        auto canvasEnt = mainCanvas.get();
+        // The canvas parents are engine strings, assigning the interned name avoids constructing them per entity
+        auto &canvasName = mainCanvas.getName();
+
+        view<PlayerComponent,
+                RigidBodyComponent,
+                HealthComponent,
+                CharacterControllerComponent,
+                InputComponent,
+                SpriteAnimationComponent>(scene).each([&](const EntityHandle &entity,
+                                                          const PlayerComponent &playerComponent,
+                                                          const RigidBodyComponent &rb,
+                                                          const HealthComponent &health,
+                                                          const CharacterControllerComponent &characterComponent,
+                                                          const InputComponent &inputComponent,
+                                                          const SpriteAnimationComponent &animComponent) {
+            auto anim = animComponent;
+            auto character = characterComponent;
+            auto input = inputComponent;
+            auto player = playerComponent;
+
+            auto weapon = weaponEntities.find(entity);
+            if (weapon == weaponEntities.end()) {
+                // The player is updated from the next step on, when the weapon entity exists
+                createWeaponEntity(entity);
+                return;
             }
 
             bool isFalling = (rb.velocity.y > character.fallVelocity || rb.velocity.y < -character.fallVelocity)
@@ -105,6 +139,8 @@ private:
 
             if (input.fire) {
                 player.player.getWeapon().pullTrigger(deltaTime);
+                input.fire = false;
+                updates.update(entity, input);
             } else {
                 player.player.getWeapon().releaseTrigger(deltaTime);
             }
@@ -118,7 +154,7 @@ private:
                 player.player.getWeapon().reload(deltaTime);
             }
 
-            auto weaponEnt = weaponEntities.at(pair.first);
+            auto weaponEnt = weapon->second;
             auto weaponSprite = weaponEnt.getComponent<SpriteComponent>();
             auto weaponTransform = weaponEnt.getComponent<TransformComponent>();
             auto weaponRect = weaponEnt.getComponent<RectTransformComponent>();
@@ -135,7 +171,7 @@ private:
                     {offset.x,
                      offset.y,
                      0});
-            weaponRect.parent = "MainCanvas";
+            weaponRect.parent = canvasName;
             weaponRect.rectTransform.size = visuals.size;
             weaponRect.rectTransform.center = visuals.center;
             if (character.facingLeft) {
@@ -170,13 +206,12 @@ private:
             }
 
             if (shoot) {
-                createSoundEffectEntity(scene.getEntityName(pair.first), scene, Uri("/sound/effects/gunshot_0.wav"));
-                auto muzzleEnt = createMuzzleEntity(pair.first, scene);
+                createSoundEffectEntity(scene.getEntityName(entity), Assets::uri(ASSET_SOUND_EFFECTS_GUNSHOT_0_WAV));
 
-                auto muzzleSprite = muzzleEnt.getComponent<SpriteComponent>();
-                auto muzzleTransform = muzzleEnt.getComponent<TransformComponent>();
-                auto muzzleRect = muzzleEnt.getComponent<RectTransformComponent>();
-                auto muzzleAnim = muzzleEnt.getComponent<SpriteAnimationComponent>();
+                SpriteComponent muzzleSprite;
+                TransformComponent muzzleTransform;
+                RectTransformComponent muzzleRect;
+                SpriteAnimationComponent muzzleAnim;
 
                 muzzleAnim.animation = visuals.muzzleFlash;
                 muzzleAnim.enabled = true;
@@ -187,7 +222,7 @@ private:
                 muzzleSprite.sprite = flash.getFrame();
                // muzzleSprite.layer = -1;
 
-                muzzleRect.parent = "MainCanvas";
+                muzzleRect.parent = canvasName;
                 muzzleRect.rectTransform.size = visuals.muzzleSize;
                 muzzleRect.rectTransform.center = visuals.muzzleCenter;
                 if (input.aim) {
@@ -206,10 +241,7 @@ private:
                                                    muzzleRect.rectTransform.rotation);
                 muzzleTransform.transform.setPosition({vec.x, vec.y, 0});
 
-                muzzleEnt.updateComponent(muzzleSprite);
-                muzzleEnt.updateComponent(muzzleTransform);
-                muzzleEnt.updateComponent(muzzleRect);
-                muzzleEnt.updateComponent(muzzleAnim);
+                createMuzzleEntity(MuzzleFlash{entity, muzzleSprite, muzzleTransform, muzzleRect, muzzleAnim});
 
                 auto aimDir = normalize(rotateVectorAroundPoint(Vec2f(-1, 0), {}, muzzleRect.rectTransform.rotation));
 
@@ -221,12 +253,13 @@ private:
                 auto muzzleWorld = TransformComponent::walkHierarchy(muzzleTransform, scene);
                 float spreadAngle = player.player.getWeapon().getBulletSpread() * v;
                 auto velocity = rotateVectorAroundPoint(aimDir, {}, spreadAngle);
-                SmallBullet::create(scene,
-                                    Transform(muzzleWorld.getPosition(),
-                                              rotation + muzzleWorld.getRotation().getEulerAngles(),
-                                              Vec3f(1) + muzzleWorld.getScale()),
-                                    Vec3f(velocity.x, velocity.y, 0) * player.player.getWeapon().getBulletSpeed(),
-                                    "MainCanvas");
+                Transform bulletTransform(muzzleWorld.getPosition(),
+                                          rotation + muzzleWorld.getRotation().getEulerAngles(),
+                                          Vec3f(1) + muzzleWorld.getScale());
+                Vec3f bulletVelocity = Vec3f(velocity.x, velocity.y, 0) * player.player.getWeapon().getBulletSpeed();
+                commands.create([bulletTransform, bulletVelocity, &canvasName](Entity &ent) {
+                    SmallBullet::create(ent, bulletTransform, bulletVelocity, canvasName);
+                });
             }
 
             weaponRect.enabled = !isDead;
@@ -253,89 +286,82 @@ private:
                 anim.animationDurationOverride = 0;
             }
 
-            scene.updateComponent(pair.first, character);
-            scene.updateComponent(pair.first, anim);
+            updates.update(entity, anim);
+            updates.update(entity, character);
+            updates.update(entity, player);
+        });
 
-            playerUpdates[pair.first] = player;
-        }
-
-        for (auto &pair: playerUpdates) {
-            scene.updateComponent(pair.first, pair.second);
-        }
+        updates.apply(scene);
 
-        delHandles.clear();
         for (auto &pair: sfxStarts) {
             if (std::chrono::duration_cast<std::chrono::seconds>(
                     std::chrono::high_resolution_clock::now() - pair.second)
                 > std::chrono::seconds(2)) {
-                delHandles.insert(pair.first);
+                commands.record([this, handle = pair.first](EntityScene &scene) {
+                    scene.destroyEntity(sfxEntities.at(handle));
+                    sfxEntities.erase(handle);
+                    sfxStarts.erase(handle);
+                });
             }
         }
-        for (auto &handle: delHandles) {
-            scene.destroyEntity(sfxEntities.at(handle));
-            sfxEntities.erase(handle);
-            sfxStarts.erase(handle);
-        }
     }
 
 private:
-    Entity &createWeaponEntity(EntityHandle targetPlayer, EntityScene &scene) {
-        auto it = weaponEntities.find(targetPlayer);
-        if (it != weaponEntities.end())
-            scene.destroyEntity(it->second);
-
-        auto ent = scene.createEntity();
+    struct MuzzleFlash {
+        EntityHandle player;
+        SpriteComponent sprite;
         TransformComponent transform;
         RectTransformComponent rect;
-        SpriteComponent sprite;
+        SpriteAnimationComponent animation;
+    };
 
-        transform.parent = scene.getEntityName(targetPlayer);
+    // The entities are created when the commands are applied, after the update
 
-        ent.createComponent(transform);
-        ent.createComponent(rect);
-        ent.createComponent(sprite);
+    void createWeaponEntity(const EntityHandle &targetPlayer) {
+        commands.record([this, targetPlayer](EntityScene &scene) {
+            auto it = weaponEntities.find(targetPlayer);
+            if (it != weaponEntities.end())
+                scene.destroyEntity(it->second);
 
-        weaponEntities[targetPlayer] = ent;
-        return weaponEntities[targetPlayer];
-    }
+            auto ent = scene.createEntity();
+            TransformComponent transform;
+            RectTransformComponent rect;
+            SpriteComponent sprite;
 
-    Entity createMuzzleEntity(EntityHandle targetPlayer, EntityScene &scene) {
-        auto ent = scene.createEntity();
+            transform.parent = scene.getEntityName(targetPlayer);
 
-        TransformComponent transform;
-        RectTransformComponent rect;
-        SpriteComponent sprite;
-        MuzzleFlashComponent muzzleFlashComponent;
-        SpriteAnimationComponent animationComponent;
-
-        sprite.sprite = {};
-        animationComponent.enabled = false;
-
-        ent = scene.createEntity();
+            ent.createComponent(transform);
+            ent.createComponent(rect);
+            ent.createComponent(sprite);
 
-        ent.createComponent(transform);
-        ent.createComponent(rect);
-        ent.createComponent(sprite);
-        ent.createComponent(animationComponent);
-        ent.createComponent(muzzleFlashComponent);
+            weaponEntities[targetPlayer] = ent;
+        });
+    }
 
-        muzzleFlashEntities[targetPlayer].emplace_back(ent);
+    void createMuzzleEntity(const MuzzleFlash &muzzleFlash) {
+        commands.create([this, muzzleFlash](Entity &ent) {
+            ent.createComponent(muzzleFlash.transform);
+            ent.createComponent(muzzleFlash.rect);
+            ent.createComponent(muzzleFlash.sprite);
+            ent.createComponent(muzzleFlash.animation);
+            ent.createComponent(MuzzleFlashComponent());
 
-        return ent;
+            muzzleFlashEntities[muzzleFlash.player].emplace_back(ent);
+        });
     }
 
-    Entity createSoundEffectEntity(const std::string &transformParent, EntityScene &scene, const Uri &uri) {
-        auto ret = scene.createEntity();
-        auto tr = TransformComponent();
-        tr.parent = transformParent;
-        ret.createComponent(tr);
-        auto snd = AudioSourceComponent();
-        snd.play = true;
-        snd.audio = ResourceHandle<Audio>(uri);
-        ret.createComponent(snd);
-        sfxEntities[ret.getHandle()] = ret;
-        sfxStarts[ret.getHandle()] = std::chrono::high_resolution_clock::now();
-        return ret;
+    void createSoundEffectEntity(const std::string &transformParent, const Uri &uri) {
+        commands.create([this, transformParent, uri](Entity &ent) {
+            auto tr = TransformComponent();
+            tr.parent = transformParent;
+            ent.createComponent(tr);
+            auto snd = AudioSourceComponent();
+            snd.play = true;
+            snd.audio = ResourceHandle<Audio>(uri);
+            ent.createComponent(snd);
+            sfxEntities[ent.getHandle()] = ent;
+            sfxStarts[ent.getHandle()] = std::chrono::high_resolution_clock::now();
+        });
     }
 
     std::map<EntityHandle, Entity> weaponEntities;
@@ -343,6 +369,11 @@ private:
     std::map<EntityHandle, Entity> sfxEntities;
     std::map<EntityHandle, std::chrono::high_resolution_clock::time_point> sfxStarts;
 
+    ComponentUpdates<InputComponent, CharacterControllerComponent, PlayerComponent, SpriteAnimationComponent> updates;
+    CommandBuffer &commands;
+
+    NamedEntity mainCanvas{"MainCanvas"};
+
     std::random_device dev;
     std::mt19937 rng;
 
@@ -24,31 +24,63 @@
 
 #include "components/backdropcomponent.hpp"
 
+#include "cvars.hpp"
+
+#include "scheduler/systemaccess.hpp"
+
+#include "ecs/view.hpp"
+#include "ecs/componentupdates.hpp"
+#include "ecs/componentversions.hpp"
+
 using namespace xng;
 
+/**
+ * The durations are read from the day_duration, night_duration and dusk_speed cvars.
+ *
+ * Once the backdrops have faded the sprites are only rewritten when day and night change or a backdrop was modified.
+ */
 class TimeSystem : public System {
 public:
-    explicit TimeSystem(double time = 0,
-                        float dayDuration = 120,
-                        float nightDuration = 180,
-                        float duskSpeed = 1)
-            : time(time),
-              dayDuration(dayDuration),
-              nightDuration(nightDuration),
-              duskSpeed(duskSpeed) {}
+    explicit TimeSystem(double time = 0)
+            : time(time) {}
+
+    static SystemAccess getAccess() {
+        return SystemAccess().reads<BackdropComponent>().writes<SpriteComponent>();
+    }
+
+    void start(EntityScene &scene, EventBus &eventBus) override {
+        versions.attach(scene);
+        settled = false;
+    }
+
+    void stop(EntityScene &scene, EventBus &eventBus) override {
+        versions.detach();
+    }
 
     void update(DeltaTime deltaTime, EntityScene &scene, EventBus &eventBus) override {
         time += deltaTime;
 
+        const auto dayDuration = CVars::dayDuration.get();
+        const auto nightDuration = CVars::nightDuration.get();
+        const auto duskSpeed = CVars::duskSpeed.get();
+
         const auto totalDuration = dayDuration + nightDuration;
         auto days = static_cast<int>(time / totalDuration);
         auto timeOfDay = time - (days * totalDuration);
 
         bool isDay = timeOfDay < dayDuration;
 
-        for (auto &pair: scene.getPool<BackdropComponent>()) {
-            auto sprite = scene.getComponent<SpriteComponent>(pair.first);
-            sprite.sprite = pair.second.daySprite;
+        if (settled && settledIsDay == isDay && !backdropsChanged(scene))
+            return;
+
+        settled = true;
+        settledIsDay = isDay;
+
+        view<BackdropComponent, SpriteComponent>(scene).each([&](const EntityHandle &entity,
+                                                                  const BackdropComponent &backdrop,
+                                                                  const SpriteComponent &spriteComponent) {
+            auto sprite = spriteComponent;
+            sprite.sprite = backdrop.daySprite;
             sprite.mixColor = ColorRGBA::black();
             if (isDay) {
                 if (sprite.mix != 0) {
@@ -63,8 +95,15 @@ public:
                         sprite.mix = 1;
                 }
             }
-            scene.updateComponent(pair.first, sprite);
-        }
+            if (sprite.mix != (isDay ? 0 : 1))
+                settled = false;
+            updates.update(entity, sprite);
+        });
+
+        updates.apply(scene);
+
+        // Taken after applying so that the own writes do not count as changes
+        checkedVersion = versions.getVersion();
     }
 
     void setTime(double value) {
@@ -76,10 +115,23 @@ public:
     }
 
 private:
+    bool backdropsChanged(const EntityScene &scene) const {
+        if (versions.changedSince<BackdropComponent>(checkedVersion))
+            return true;
+        for (auto &pair: scene.getPool<BackdropComponent>()) {
+            if (versions.changedSince<SpriteComponent>(pair.first, checkedVersion))
+                return true;
+        }
+        return false;
+    }
+
     double time;
-    const float dayDuration;
-    const float nightDuration;
-    const float duskSpeed;
+    ComponentUpdates<SpriteComponent> updates;
+
+    ComponentVersions<BackdropComponent, SpriteComponent> versions;
+    uint64_t checkedVersion = 0;
+    bool settled = false; // True if the last pass wrote the final mix of the current time of day
+    bool settledIsDay = false;
 };
 
 #endif //FOXTROT_TIMESYSTEM_HPP
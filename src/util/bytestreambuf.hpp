@@ -0,0 +1,68 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_BYTESTREAMBUF_HPP
+#define FOXTROT_BYTESTREAMBUF_HPP
+
+#include <streambuf>
+#include <span>
+#include <cstddef>
+
+/**
+ * A read only stream buffer which references existing memory instead of copying it.
+ * The referenced memory must outlive the stream buffer.
+ */
+class ByteStreamBuf : public std::streambuf {
+public:
+    explicit ByteStreamBuf(std::span<const std::byte> bytes) {
+        auto *begin = const_cast<char *>(reinterpret_cast<const char *>(bytes.data()));
+        setg(begin, begin, begin + bytes.size());
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+        off_type base;
+        switch (dir) {
+            case std::ios_base::beg:
+                base = 0;
+                break;
+            case std::ios_base::cur:
+                base = gptr() - eback();
+                break;
+            case std::ios_base::end:
+                base = egptr() - eback();
+                break;
+            default:
+                return pos_type(off_type(-1));
+        }
+        return seekpos(pos_type(base + off), which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        off_type off = pos;
+        if (!(which & std::ios_base::in) || off < 0 || off > egptr() - eback())
+            return pos_type(off_type(-1));
+        setg(eback(), eback() + off, egptr());
+        return pos;
+    }
+};
+
+#endif //FOXTROT_BYTESTREAMBUF_HPP
@@ -0,0 +1,191 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_FRAMEPACER_HPP
+#define FOXTROT_FRAMEPACER_HPP
+
+#include <chrono>
+#include <thread>
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <optional>
+
+/**
+ * Paces frames to a target rate with a coarse sleep followed by a short spin until the deadline.
+ *
+ * The pacer measures how late the OS wakes the thread from a sleep and spins for that long before the deadline
+ * so that the wake up error does not delay the frame.
+ *
+ * In low latency mode the frame starts as late as possible, the expected frame duration before the end of its slot,
+ * so that input is sampled and the simulation runs just before the frame is presented.
+ *
+ * The intervals between the ends of the frames are recorded to report the pacing jitter.
+ */
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::duration<double> Seconds;
+
+    struct Statistics {
+        size_t frames = 0; // The number of recorded intervals
+        double meanInterval = 0; // The mean interval between frames in milliseconds
+        double jitter = 0; // The standard deviation of the interval in milliseconds
+        double maxDeviation = 0; // The largest deviation of an interval from the mean in milliseconds
+        size_t lateFrames = 0; // The number of intervals longer than the target interval by more than 1 millisecond
+        double sleepOvershoot = 0; // The estimated time the OS wakes up late in milliseconds
+        double predictedWork = 0; // The expected frame duration used in low latency mode in milliseconds
+    };
+
+    /**
+     * @param fps The target frame rate, 0 disables the pacing while the intervals are still recorded
+     */
+    void setTargetFrameRate(double fps) {
+        auto interval = fps > 0 ? Seconds(1.0 / fps) : Seconds(0);
+        if (interval != targetInterval) {
+            targetInterval = interval;
+            slotStart.reset();
+        }
+    }
+
+    void setLowLatency(bool value) {
+        lowLatency = value;
+    }
+
+    /**
+     * Wait for the start of the next frame, called before any work of the frame is done.
+     */
+    void beginFrame() {
+        if (targetInterval > Seconds(0) && slotStart) {
+            auto wake = *slotStart;
+            if (lowLatency) {
+                wake += std::chrono::duration_cast<Clock::duration>(
+                        std::max(Seconds(0), targetInterval - predictedWork - LOW_LATENCY_MARGIN));
+            }
+            waitUntil(wake);
+        }
+        frameStart = Clock::now();
+        if (!slotStart) {
+            slotStart = frameStart;
+        }
+    }
+
+    /**
+     * Record the end of the frame and schedule the next one, called after the frame was presented.
+     */
+    void endFrame() {
+        auto end = Clock::now();
+
+        Seconds work = end - frameStart;
+        if (work > predictedWork) {
+            predictedWork = work;
+        } else {
+            predictedWork = predictedWork * (1 - WORK_DECAY) + work * WORK_DECAY;
+        }
+
+        if (lastEnd) {
+            intervals.at(intervalIndex % intervals.size()) = Seconds(end - *lastEnd).count();
+            intervalIndex++;
+        }
+        lastEnd = end;
+
+        if (targetInterval > Seconds(0) && slotStart) {
+            *slotStart += std::chrono::duration_cast<Clock::duration>(targetInterval);
+            // Do not try to catch up on frames which are behind by more than a frame
+            if (end - *slotStart > targetInterval) {
+                slotStart = end;
+            }
+        }
+    }
+
+    Statistics getStatistics() const {
+        Statistics ret;
+        ret.frames = std::min(intervalIndex, intervals.size());
+        ret.sleepOvershoot = sleepOvershoot.count() * 1000;
+        ret.predictedWork = predictedWork.count() * 1000;
+        if (ret.frames == 0)
+            return ret;
+
+        double sum = 0;
+        for (size_t i = 0; i < ret.frames; i++) {
+            sum += intervals.at(i);
+        }
+        auto mean = sum / static_cast<double>(ret.frames);
+
+        double variance = 0;
+        for (size_t i = 0; i < ret.frames; i++) {
+            auto deviation = intervals.at(i) - mean;
+            variance += deviation * deviation;
+            ret.maxDeviation = std::max(ret.maxDeviation, std::abs(deviation) * 1000);
+            if (targetInterval > Seconds(0) && intervals.at(i) > targetInterval.count() + 0.001) {
+                ret.lateFrames++;
+            }
+        }
+        ret.meanInterval = mean * 1000;
+        ret.jitter = std::sqrt(variance / static_cast<double>(ret.frames)) * 1000;
+        return ret;
+    }
+
+    void resetStatistics() {
+        intervalIndex = 0;
+        lastEnd.reset();
+    }
+
+private:
+    static constexpr size_t INTERVAL_COUNT = 512;
+    static constexpr double WORK_DECAY = 0.05; // The rate at which the predicted work decays to shorter frames
+    static constexpr double OVERSHOOT_DECAY = 0.01; // The rate at which the overshoot estimate decays
+    static constexpr Seconds MIN_SPIN = Seconds(0.0002);
+    static constexpr Seconds MAX_SPIN = Seconds(0.004);
+    static constexpr Seconds LOW_LATENCY_MARGIN = Seconds(0.0005);
+
+    void waitUntil(Clock::time_point deadline) {
+        auto spin = std::clamp(sleepOvershoot, MIN_SPIN, MAX_SPIN);
+        auto sleepEnd = deadline - std::chrono::duration_cast<Clock::duration>(spin);
+        auto now = Clock::now();
+        if (sleepEnd > now) {
+            std::this_thread::sleep_until(sleepEnd);
+            Seconds overshoot = Clock::now() - sleepEnd;
+            // Rise immediately and decay slowly so that occasional late wake ups are still covered by the spin
+            if (overshoot > sleepOvershoot) {
+                sleepOvershoot = overshoot;
+            } else {
+                sleepOvershoot = sleepOvershoot * (1 - OVERSHOOT_DECAY) + overshoot * OVERSHOOT_DECAY;
+            }
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    Seconds targetInterval = Seconds(0);
+    bool lowLatency = false;
+
+    std::optional<Clock::time_point> slotStart; // The start of the current frame slot
+    Clock::time_point frameStart;
+    std::optional<Clock::time_point> lastEnd;
+
+    Seconds predictedWork = Seconds(0);
+    Seconds sleepOvershoot = Seconds(0.001);
+
+    std::array<double, INTERVAL_COUNT> intervals{}; // The recent intervals between the frame ends in seconds
+    size_t intervalIndex = 0;
+};
+
+#endif //FOXTROT_FRAMEPACER_HPP
@@ -0,0 +1,189 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FOXTROT_TASKGRAPH_HPP
+#define FOXTROT_TASKGRAPH_HPP
+
+#include <functional>
+#include <condition_variable>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+/**
+ * A set of named tasks with dependencies between them.
+ *
+ * Worker tasks are dispatched to the thread pool as soon as their dependencies have finished,
+ * main thread tasks run on the thread calling run() in the order they were added.
+ */
+class TaskGraph {
+public:
+    enum Affinity {
+        WORKER,
+        MAIN_THREAD, // For tasks which access the window or the render device
+    };
+
+    struct Node {
+        std::string name;
+        std::set<std::string> dependencies;
+        std::function<void()> task;
+        Affinity affinity;
+
+        bool started = false;
+        bool finished = false;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    void add(const std::string &name,
+             std::set<std::string> dependencies,
+             std::function<void()> task,
+             Affinity affinity = WORKER) {
+        for (auto &node: nodes) {
+            if (node.name == name)
+                throw std::runtime_error("Task " + name + " is already added to the graph");
+        }
+        // Dependencies must be added first, an unknown dependency would otherwise be treated as finished
+        for (auto &dependency: dependencies) {
+            if (std::none_of(nodes.begin(), nodes.end(), [&](const Node &node) { return node.name == dependency; }))
+                throw std::runtime_error("Task " + name + " depends on unknown task " + dependency);
+        }
+        nodes.emplace_back(Node{name, std::move(dependencies), std::move(task), affinity});
+    }
+
+    /**
+     * Run all tasks and return once they have finished.
+     * If a task throws no further tasks are started and the exception is rethrown after the running tasks have finished.
+     */
+    void run() {
+        origin = std::chrono::steady_clock::now();
+
+        std::vector<std::shared_ptr<Task>> tasks;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            std::vector<Node *> ready;
+            Node *mainTask = nullptr;
+            size_t running = 0;
+            bool done = true;
+            for (auto &node: nodes) {
+                if (!node.finished)
+                    done = false;
+                if (node.started) {
+                    if (!node.finished)
+                        running++;
+                    continue;
+                }
+                if (exception || !isReady(node))
+                    continue;
+                if (node.affinity == WORKER) {
+                    node.started = true;
+                    ready.emplace_back(&node);
+                } else if (mainTask == nullptr) {
+                    mainTask = &node;
+                }
+            }
+
+            if (done || (exception && running == 0 && ready.empty()))
+                break;
+
+            if (!ready.empty() || mainTask != nullptr) {
+                if (mainTask != nullptr)
+                    mainTask->started = true;
+                lock.unlock();
+                for (auto *node: ready) {
+                    tasks.emplace_back(ThreadPool::getPool().addTask([this, node]() { execute(*node); }));
+                }
+                if (mainTask != nullptr)
+                    execute(*mainTask);
+                lock.lock();
+            } else if (running > 0) {
+                condition.wait(lock);
+            } else {
+                throw std::runtime_error("Task graph contains unresolvable dependencies");
+            }
+        }
+        lock.unlock();
+
+        for (auto &task: tasks) {
+            task->join();
+        }
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    /**
+     * @return The tasks in the order they were added, including the time they started and finished
+     */
+    const std::vector<Node> &getNodes() const {
+        return nodes;
+    }
+
+    std::chrono::steady_clock::time_point getOrigin() const {
+        return origin;
+    }
+
+private:
+    // Requires mutex to be locked
+    bool isReady(const Node &node) const {
+        for (auto &dependency: node.dependencies) {
+            for (auto &other: nodes) {
+                if (other.name == dependency && !other.finished)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void execute(Node &node) {
+        auto start = std::chrono::steady_clock::now();
+        std::exception_ptr error;
+        try {
+            node.task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> guard(mutex);
+        node.start = start;
+        node.end = end;
+        node.finished = true;
+        if (error && !exception)
+            exception = error;
+        condition.notify_all();
+    }
+
+    std::vector<Node> nodes;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::exception_ptr exception;
+    std::chrono::steady_clock::time_point origin;
+};
+
+#endif //FOXTROT_TASKGRAPH_HPP
@@ -24,6 +24,8 @@
 
 #include "item.hpp"
 
+#include "resource/assets.hpp"
+
 class Weapon {
 public:
     enum Type {
@@ -22,6 +22,7 @@
 
 #include <set>
 #include "weapon.hpp"
+#include "cvars.hpp"
 
 class Gatling : public Weapon {
 public:
@@ -67,14 +68,14 @@ public:
               gatling_lowammo_6_cycle(std::move(gatling_lowammo_6_cycle)),
               gatling_unloaded_0_cycle(std::move(gatling_unloaded_0_cycle)),
               gatling_unloaded_1_cycle(std::move(gatling_unloaded_1_cycle)) {
-        clipSize = 300;
         reloadDuration = 1;
-        bulletSpread = 10;
+        applyCVars();
     }
 
     ~Gatling() override = default;
 
     void update(DeltaTime deltaTime) override {
+        applyCVars();
         if (engagedRotor) {
             engagedRotor = false;
         } else {
@@ -161,7 +162,7 @@ public:
                 break;
         }
 
-        ret.muzzleFlash = ResourceHandle<SpriteAnimation>(Uri("animations/muzzle_a.json"));
+        ret.muzzleFlash = muzzleFlash;
         ret.muzzleSize = {100, 100};
         ret.muzzleCenter = {10, 50};
         ret.muzzleOffset = {-80, 0};
@@ -198,12 +199,17 @@ public:
     void accelerateRotor(DeltaTime deltaTime) {
         engagedRotor = true;
         rpm += deltaTime * spinAcceleration;
-        if (rpm >= maxRpm) {
-            rpm = maxRpm;
+        if (rpm >= CVars::gatlingRpm.get()) {
+            rpm = CVars::gatlingRpm.get();
         }
     }
 
 private:
+    void applyCVars() {
+        clipSize = CVars::gatlingClipSize.get();
+        bulletSpread = CVars::gatlingBulletSpread.get();
+    }
+
     bool cycle = false;
     bool chamber = false;
     bool engagedRotor = false;
@@ -212,7 +218,6 @@ private:
 
     float rpm = 0;
 
-    float maxRpm = 5000;
     float spinAcceleration = 500;
     float spinDeceleration = 1000;
 
@@ -236,6 +241,7 @@ private:
     ResourceHandle<Sprite> gatling_lowammo_6_cycle;
     ResourceHandle<Sprite> gatling_unloaded_0_cycle;
     ResourceHandle<Sprite> gatling_unloaded_1_cycle;
+    ResourceHandle<SpriteAnimation> muzzleFlash{Assets::uri(ASSET_ANIMATIONS_MUZZLE_A_JSON)};
 };
 
 #endif //FOXTROT_GATLING_HPP
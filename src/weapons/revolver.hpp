@@ -21,19 +21,25 @@
 #define FOXTROT_REVOLVER_HPP
 
 #include "weapon.hpp"
+#include "cvars.hpp"
 
 class Revolver : public Weapon {
 public:
     explicit Revolver()
-            : sprite(Uri("sprites/revolver.json/0")),
-              spriteReload(Uri("sprites/revolver.json/2")) {
+            : sprite(Assets::uri(ASSET_SPRITES_REVOLVER_JSON_0)),
+              spriteReload(Assets::uri(ASSET_SPRITES_REVOLVER_JSON_2)),
+              muzzleFlash(Assets::uri(ASSET_ANIMATIONS_MUZZLE_A_JSON)) {
         reloadDuration = 2;
-        clipSize = 9;
-        bulletSpread = 5;
+        applyCVars();
     }
 
     ~Revolver() override = default;
 
+    void update(DeltaTime deltaTime) override {
+        applyCVars();
+        Weapon::update(deltaTime);
+    }
+
     Type getType() const override {
         return REVOLVER;
     }
@@ -56,7 +62,7 @@ public:
             ret.sprite = sprite;
         }
 
-        ret.muzzleFlash = ResourceHandle<SpriteAnimation>(Uri("animations/muzzle_a.json"));
+        ret.muzzleFlash = muzzleFlash;
         ret.muzzleSize = {50, 50};
         ret.muzzleCenter = {5, 25};
         ret.muzzleOffset = {-60, 15};
@@ -86,9 +92,15 @@ public:
 
 
 private:
+    void applyCVars() {
+        clipSize = CVars::revolverClipSize.get();
+        bulletSpread = CVars::revolverBulletSpread.get();
+    }
+
     bool hammer = false;
     ResourceHandle<Sprite> sprite;
     ResourceHandle<Sprite> spriteReload;
+    ResourceHandle<SpriteAnimation> muzzleFlash;
 };
 
 #endif //FOXTROT_REVOLVER_HPP
@@ -0,0 +1,345 @@
+/**
+ *  xEngine - C++ game engine library
+ *  Copyright (C) 2021  Julian Zampiccoli
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Packs the sprite regions referenced by the sprite descriptors of an asset directory into texture atlases.
+ *
+ * Usage: atlaspacker <asset directory> [atlas size]
+ *
+ * Every sprite of the descriptors in the sprites directory is copied into images/atlas_<n>.png and its descriptor is rewritten
+ * to reference the region inside the atlas. Identical regions are stored once.
+ * Sprites whose image cannot be read are left unchanged.
+ *
+ * Packing is deterministic: the descriptors are read in path order and the regions are placed in a fixed order.
+ * Sprites which already reference an atlas are not packed again and their atlases are kept, so running the packer
+ * on its own output does not modify any file.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <map>
+#include <tuple>
+
+#include <png.h>
+
+#include "xng/xng.hpp"
+
+using namespace xng;
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels; // RGBA
+};
+
+struct Region {
+    std::string image;
+    int x, y, width, height;
+
+    bool operator<(const Region &other) const {
+        return std::tie(image, x, y, width, height)
+               < std::tie(other.image, other.x, other.y, other.width, other.height);
+    }
+};
+
+struct Placement {
+    int atlas;
+    int x, y;
+};
+
+static const int PADDING = 2; // Transparent border around each region to avoid bleeding when filtering
+
+static const std::string ATLAS_PREFIX = "images/atlas_";
+static const std::string ATLAS_SUFFIX = ".png";
+
+static bool readPng(const std::filesystem::path &path, Image &image) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, path.c_str()))
+        return false;
+    png.format = PNG_FORMAT_RGBA;
+    image.width = static_cast<int>(png.width);
+    image.height = static_cast<int>(png.height);
+    image.pixels.resize(PNG_IMAGE_SIZE(png));
+    if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr)) {
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+static bool writePng(const std::filesystem::path &path, const Image &image) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = image.width;
+    png.height = image.height;
+    png.format = PNG_FORMAT_RGBA;
+    return png_image_write_to_file(&png, path.c_str(), 0, image.pixels.data(), 0, nullptr);
+}
+
+static Message readJson(const std::filesystem::path &path) {
+    std::ifstream stream(path);
+    return JsonProtocol().deserialize(stream);
+}
+
+static void writeJson(const std::filesystem::path &path, const Message &message) {
+    std::ofstream stream(path);
+    JsonProtocol().serialize(stream, message);
+}
+
+static std::string atlasUri(int index) {
+    return ATLAS_PREFIX + std::to_string(index) + ATLAS_SUFFIX;
+}
+
+/**
+ * @return The index of the atlas referenced by the uri or -1 if the uri does not reference an atlas
+ */
+static int getAtlasIndex(const std::string &uri) {
+    if (uri.size() <= ATLAS_PREFIX.size() + ATLAS_SUFFIX.size()
+        || uri.compare(0, ATLAS_PREFIX.size(), ATLAS_PREFIX) != 0
+        || uri.compare(uri.size() - ATLAS_SUFFIX.size(), ATLAS_SUFFIX.size(), ATLAS_SUFFIX) != 0)
+        return -1;
+    auto number = uri.substr(ATLAS_PREFIX.size(), uri.size() - ATLAS_PREFIX.size() - ATLAS_SUFFIX.size());
+    if (number.empty() || !std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        return -1;
+    return std::stoi(number);
+}
+
+/**
+ * @return The image uri of the sprite or an empty string if the sprite does not reference an image
+ */
+static std::string getImageUri(Message &sprite) {
+    if (!sprite.has("image") || !sprite["image"].has("uri"))
+        return {};
+    return sprite["image"]["uri"].asString();
+}
+
+/**
+ * @return The region of the image referenced by the sprite, the whole image if the sprite does not define an offset
+ */
+static Region getRegion(Message &sprite, const std::string &uri, const Image &image) {
+    Region ret{uri, 0, 0, image.width, image.height};
+    if (sprite.has("offset")) {
+        auto &offset = sprite["offset"];
+        if (offset.has("position")) {
+            offset["position"].value("x", ret.x, 0);
+            offset["position"].value("y", ret.y, 0);
+        }
+        if (offset.has("dimensions")) {
+            offset["dimensions"].value("x", ret.width, image.width);
+            offset["dimensions"].value("y", ret.height, image.height);
+        }
+    }
+    ret.x = std::clamp(ret.x, 0, image.width);
+    ret.y = std::clamp(ret.y, 0, image.height);
+    ret.width = std::clamp(ret.width, 0, image.width - ret.x);
+    ret.height = std::clamp(ret.height, 0, image.height - ret.y);
+    return ret;
+}
+
+/**
+ * Shelf packing of the regions sorted by decreasing height.
+ *
+ * The regions are given in their set order and sorted stably so that equal inputs always produce equal atlases.
+ *
+ * @param atlasIndices The indices to assign to the created atlases, in order
+ */
+static std::map<Region, Placement> pack(std::vector<Region> regions,
+                                        int atlasSize,
+                                        const std::vector<int> &atlasIndices,
+                                        std::map<int, Image> &atlases) {
+    std::stable_sort(regions.begin(), regions.end(), [](const Region &a, const Region &b) {
+        return a.height != b.height ? a.height > b.height : a.width > b.width;
+    });
+
+    std::map<Region, Placement> ret;
+    std::vector<int> usedHeight;
+
+    int atlas = -1, shelfX = 0, shelfY = 0, shelfHeight = 0;
+    for (auto &region: regions) {
+        auto w = region.width + PADDING * 2;
+        auto h = region.height + PADDING * 2;
+        if (w > atlasSize || h > atlasSize) {
+            std::cerr << "Region of " << region.image << " exceeds the atlas size, skipping\n";
+            continue;
+        }
+        if (atlas < 0 || shelfX + w > atlasSize) {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        if (atlas < 0 || shelfY + h > atlasSize) {
+            atlas++;
+            usedHeight.emplace_back(0);
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+        }
+        ret[region] = Placement{atlasIndices.at(atlas), shelfX + PADDING, shelfY + PADDING};
+        shelfX += w;
+        shelfHeight = std::max(shelfHeight, h);
+        usedHeight.at(atlas) = std::max(usedHeight.at(atlas), shelfY + h);
+    }
+
+    for (size_t i = 0; i < usedHeight.size(); i++) {
+        Image image;
+        image.width = atlasSize;
+        image.height = usedHeight[i];
+        image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4, 0);
+        atlases[atlasIndices.at(i)] = std::move(image);
+    }
+
+    return ret;
+}
+
+static void blit(const Image &source, const Region &region, Image &target, int targetX, int targetY) {
+    for (int row = 0; row < region.height; row++) {
+        auto *src = source.pixels.data() + ((static_cast<size_t>(region.y) + row) * source.width + region.x) * 4;
+        auto *dst = target.pixels.data() + ((static_cast<size_t>(targetY) + row) * target.width + targetX) * 4;
+        std::memcpy(dst, src, static_cast<size_t>(region.width) * 4);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: atlaspacker <asset directory> [atlas size]\n";
+        return 1;
+    }
+
+    std::filesystem::path assetDir(argv[1]);
+    int atlasSize = argc > 2 ? std::stoi(argv[2]) : 2048;
+
+    // Sorted so that the packing does not depend on the directory iteration order
+    std::set<std::filesystem::path> paths;
+    for (auto &entry: std::filesystem::directory_iterator(assetDir / "sprites")) {
+        if (entry.path().extension() == ".json")
+            paths.insert(entry.path());
+    }
+
+    std::map<std::filesystem::path, Message> descriptors;
+    std::map<std::string, Image> images;
+    std::set<Region> regionSet;
+    std::set<int> usedAtlases; // The atlases referenced by already packed sprites
+
+    for (auto &path: paths) {
+        auto json = readJson(path);
+        if (!json.has("sprites"))
+            continue;
+
+        for (auto sprite: json["sprites"].asList()) {
+            auto uri = getImageUri(sprite);
+            if (uri.empty())
+                continue;
+
+            auto atlas = getAtlasIndex(uri);
+            if (atlas >= 0) {
+                usedAtlases.insert(atlas);
+                continue;
+            }
+
+            auto it = images.find(uri);
+            if (it == images.end()) {
+                Image img;
+                if (!readPng(assetDir / uri, img)) {
+                    std::cerr << "Failed to read " << uri << ", " << path.filename().string()
+                              << " is not packed\n";
+                }
+                it = images.emplace(uri, std::move(img)).first;
+            }
+            if (it->second.pixels.empty())
+                continue;
+
+            regionSet.insert(getRegion(sprite, uri, it->second));
+        }
+
+        descriptors[path] = std::move(json);
+    }
+
+    if (regionSet.empty()) {
+        std::cout << "No unpacked sprites, " << usedAtlases.size() << " atlases are up to date\n";
+        return 0;
+    }
+
+    // New atlases take the lowest indices not referenced by packed sprites, unreferenced atlases are stale
+    std::vector<int> atlasIndices;
+    for (int i = 0; atlasIndices.size() < regionSet.size(); i++) {
+        if (usedAtlases.find(i) == usedAtlases.end())
+            atlasIndices.emplace_back(i);
+    }
+
+    std::map<int, Image> atlases;
+    auto placements = pack(std::vector<Region>(regionSet.begin(), regionSet.end()), atlasSize, atlasIndices, atlases);
+
+    for (auto &pair: placements) {
+        blit(images.at(pair.first.image), pair.first, atlases.at(pair.second.atlas), pair.second.x, pair.second.y);
+    }
+
+    for (auto &pair: atlases) {
+        if (!writePng(assetDir / atlasUri(pair.first), pair.second)) {
+            std::cerr << "Failed to write " << atlasUri(pair.first) << "\n";
+            return 1;
+        }
+    }
+
+    size_t packedSprites = 0;
+    for (auto &pair: descriptors) {
+        auto sprites = pair.second["sprites"].asList();
+        bool modified = false;
+        for (auto &sprite: sprites) {
+            auto uri = getImageUri(sprite);
+            if (uri.empty() || getAtlasIndex(uri) >= 0 || images.at(uri).pixels.empty())
+                continue;
+
+            auto it = placements.find(getRegion(sprite, uri, images.at(uri)));
+            if (it == placements.end())
+                continue;
+
+            sprite["image"]["uri"] = atlasUri(it->second.atlas);
+            auto position = Message(Message::DICTIONARY);
+            position["x"] = it->second.x;
+            position["y"] = it->second.y;
+            auto dimensions = Message(Message::DICTIONARY);
+            dimensions["x"] = it->first.width;
+            dimensions["y"] = it->first.height;
+            auto offset = Message(Message::DICTIONARY);
+            offset["position"] = position;
+            offset["dimensions"] = dimensions;
+            sprite["offset"] = offset;
+            modified = true;
+            packedSprites++;
+        }
+
+        // Descriptors without newly packed sprites are not rewritten
+        if (modified) {
+            pair.second["sprites"] = Message(sprites);
+            writeJson(pair.first, pair.second);
+        }
+    }
+
+    std::cout << "Packed " << packedSprites << " sprites (" << placements.size() << " unique regions from "
+              << images.size() << " images) into " << atlases.size() << " atlases\n";
+
+    return 0;
+}